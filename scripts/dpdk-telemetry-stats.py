@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+# (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved.
+#
+# Read ethdev statistics from telemetry socket of a running DPDK
+# application.
+#
+# Usage: dpdk-telemetry-stats.py PROGRAM INTERVAL_MS|xstats PORTS
+#
+# PROGRAM is the application program name suffix, INTERVAL_MS is the
+# sampling interval in milliseconds, xstats dumps extended statistics
+# once, PORTS is comma-separated list of port IDs. The socket is found
+# by --file-prefix EAL argument of the application process, so exactly
+# one process of the application must be running.
+
+import glob
+import json
+import os
+import socket
+import sys
+import time
+
+
+def file_prefix(pid, program):
+    try:
+        with open('/proc/%s/cmdline' % pid, 'rb') as f:
+            argv = f.read().decode().split('\0')
+    except OSError:
+        return None
+    if not os.path.basename(argv[0]).endswith(program):
+        return None
+    for i, arg in enumerate(argv):
+        if arg == '--file-prefix' and i + 1 < len(argv):
+            return argv[i + 1]
+        if arg.startswith('--file-prefix='):
+            return arg.split('=', 1)[1]
+    return 'rte'
+
+
+def main():
+    program, mode, ports = sys.argv[1], sys.argv[2], sys.argv[3].split(',')
+
+    pids = [p for p in os.listdir('/proc')
+            if p.isdigit() and int(p) != os.getpid()]
+    prefixes = set(filter(None, (file_prefix(p, program) for p in pids)))
+    if len(prefixes) != 1:
+        sys.exit('Cannot choose %s process, file prefixes: %s' %
+                 (program, sorted(prefixes)))
+    pfx = prefixes.pop()
+
+    socks = (glob.glob('/var/run/dpdk/%s/dpdk_telemetry.v2' % pfx) +
+             glob.glob('/run/user/*/dpdk/%s/dpdk_telemetry.v2' % pfx))
+    if len(socks) != 1:
+        sys.exit('Cannot find telemetry socket of file prefix %s: %s' %
+                 (pfx, socks))
+
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+    s.connect(socks[0])
+    s.recv(1024)
+
+    def get(cmd):
+        s.send(cmd.encode())
+        return json.loads(s.recv(1 << 20).decode())[cmd.split(',')[0]]
+
+    if mode == 'xstats':
+        for p in ports:
+            for k, v in get('/ethdev/xstats,' + p).items():
+                print('xstat %s %s %d' % (p, k, v))
+        return
+
+    while True:
+        for p in ports:
+            st = get('/ethdev/stats,' + p)
+            print('port %s time %.6f ipackets %d opackets %d' %
+                  (p, time.time(), st['ipackets'], st['opackets']),
+                  flush=True)
+        time.sleep(int(mode) / 1000.0)
+
+
+if __name__ == '__main__':
+    main()
@@ -11,4 +11,8 @@ for ta_type in ${TE_TA_TYPES} ; do
 
     cp -p "${TE_PREFIX}/bin/dpdk-testpmd" "${TE_AGENTS_INST}/${ta_type}/"
     cp -p "${TE_PREFIX}/bin/dpdk-l2fwd" "${TE_AGENTS_INST}/${ta_type}/"
+    cp -p "$(dirname "$0")/dpdk-telemetry-stats.py" \
+        "${TE_AGENTS_INST}/${ta_type}/"
+    test -f "${TE_PREFIX}/bin/dpdk-l3fwd" &&
+        cp -p "${TE_PREFIX}/bin/dpdk-l3fwd" "${TE_AGENTS_INST}/${ta_type}/"
 done
@@ -65,6 +65,15 @@ EOF
   --iut-dpdk-drv=<NAME>     DPDK-compatible driver to be used on IUT agent
   --tst-dpdk-drv=<NAME>     DPDK-compatible driver to be used on TST agent
   --prevent-netdrv-autobind Prevent net driver autobinding to other PCI instances
+  --perf-stat               Collect hardware performance counters on IUT
+                            forwarding cores in performance tests
+  --perf-record             Profile IUT forwarding cores in performance tests
+                            and store folded call stacks in logs directory
+  --telemetry-stats=<MS>    Sample IUT statistics in performance tests from
+                            DPDK telemetry socket every <MS> milliseconds
+  --perf-baselines=<FILE>   Performance baselines to compare performance tests
+                            results with (default is perf-baselines.txt next
+                            to TRC database)
 
   --no-meta                 Do not generate testing metadata
   --publish                 Publish testing logs to Bublik
@@ -234,6 +243,18 @@ for opt ; do
         --prevent-netdrv-autobind)
             export TE_PREVENT_NETDRV_AUTOBIND=1
             ;;
+        --perf-stat)
+            export TE_PERF_STAT=yes
+            ;;
+        --perf-record)
+            export TE_PERF_RECORD=yes
+            ;;
+        --telemetry-stats=*)
+            export TE_TELEMETRY_STATS_INTERVAL="${opt#--telemetry-stats=}"
+            ;;
+        --perf-baselines=*)
+            export TE_PERF_BASELINES="${opt#--perf-baselines=}"
+            ;;
         --no-meta)
             TE_RUN_META=no
             RUN_OPTS+=("${opt}")
@@ -317,6 +338,10 @@ MY_OPTS+=(--conf-dirs="${TE_TS_CONFDIR}:${TE_TS_RIGSDIR}${TE_TS_RIGSDIR:+:}${SF_
 
 MY_OPTS+=(--trc-db="${TE_TS_TRC_DB}")
 [[ -z "${TE_TS_RIGS_TRC_DB}" ]] || MY_OPTS+=(--trc-db="${TE_TS_RIGS_TRC_DB}")
+if [[ -z "${TE_PERF_BASELINES}" ]] \
+   && [[ -r "${TE_TS_TRC_DB%/*}/perf-baselines.txt" ]] ; then
+    export TE_PERF_BASELINES="${TE_TS_TRC_DB%/*}/perf-baselines.txt"
+fi
 MY_OPTS+=(--trc-comparison=normalised)
 MY_OPTS+=(--trc-html=trc-brief.html)
 MY_OPTS+=(--trc-no-expected)
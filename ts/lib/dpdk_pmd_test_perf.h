@@ -11,6 +11,19 @@
 #ifndef __TS_DPDK_PMD_PERF_TEST_H__
 #define __TS_DPDK_PMD_PERF_TEST_H__
 
+#include <math.h>
+#include <signal.h>
+#include <stdarg.h>
+
+#include "te_mi_log.h"
+#include "te_str.h"
+#include "tapi_job.h"
+#include "tapi_job_factory_rpc.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "rcf_api.h"
+
 #define TEST_MEAS_MAX_NUM_DATAPOINTS 60
 #define TEST_MEAS_MIN_NUM_DATAPOINTS 10
 #define TEST_MEAS_ALLOWED_SKIPS 3
@@ -20,19 +33,1721 @@
     (TE_MEAS_STATS_INIT_STAB_REQUIRED | TE_MEAS_STATS_INIT_SUMMARY_REQUIRED |  \
      TE_MEAS_STATS_INIT_IGNORE_ZEROS)
 
+/** Normal distribution quantile for 95% confidence interval */
+#define TEST_MEAS_CI_Z 1.96
+
+/** Optional test parameter: target relative width of 95% CI of the mean */
+#define TEST_MEAS_PARAM_CI_WIDTH "meas_ci_width"
+/** Optional test parameter: minimum number of datapoints */
+#define TEST_MEAS_PARAM_MIN_DATAPOINTS "meas_min_datapoints"
+/** Optional test parameter: maximum number of datapoints (time budget) */
+#define TEST_MEAS_PARAM_MAX_DATAPOINTS "meas_max_datapoints"
+
 /**
- * Initialize measurements statistics with defaults.
+ * Initialize measurements statistics. Defaults may be overridden by
+ * optional test parameters:
+ * - @c meas_min_datapoints: the number of the last datapoints which must
+ *   be stable to stop measurements;
+ * - @c meas_max_datapoints: the number of datapoints after which
+ *   measurements are stopped even if they are not stable;
+ * - @c meas_ci_width: target relative width of 95% confidence interval of
+ *   the mean of stable datapoints; required coefficient of variation is
+ *   derived from it.
+ *
+ * @param params        Test parameters
+ * @param meas_stats    Statistics to initialize
  */
 extern te_errno
-test_meas_stats_init(te_meas_stats_t *meas_stats)
+test_meas_stats_init(const te_kvpair_h *params, te_meas_stats_t *meas_stats)
 {
+    unsigned int min_datapoints = TEST_MEAS_MIN_NUM_DATAPOINTS;
+    unsigned int max_datapoints = TEST_MEAS_MAX_NUM_DATAPOINTS;
+    double required_cv = TEST_MEAS_REQUIRED_CV;
+    const char *value;
+    double ci_width;
+    te_errno rc;
+
+    value = te_kvpairs_get(params, TEST_MEAS_PARAM_MIN_DATAPOINTS);
+    if (value != NULL)
+    {
+        rc = te_strtoui(value, 0, &min_datapoints);
+        if (rc != 0)
+            return rc;
+    }
+
+    value = te_kvpairs_get(params, TEST_MEAS_PARAM_MAX_DATAPOINTS);
+    if (value != NULL)
+    {
+        rc = te_strtoui(value, 0, &max_datapoints);
+        if (rc != 0)
+            return rc;
+    }
+
+    if (min_datapoints == 0 || min_datapoints > max_datapoints)
+    {
+        ERROR("Invalid measurements datapoints range %u..%u",
+              min_datapoints, max_datapoints);
+        return TE_RC(TE_TAPI, TE_EINVAL);
+    }
+
+    value = te_kvpairs_get(params, TEST_MEAS_PARAM_CI_WIDTH);
+    if (value != NULL)
+    {
+        rc = te_strtod(value, &ci_width);
+        if (rc != 0)
+            return rc;
+        if (ci_width <= 0)
+        {
+            ERROR("Invalid target confidence interval width %s", value);
+            return TE_RC(TE_TAPI, TE_EINVAL);
+        }
+
+        /* CI width is 2 * z * CV / sqrt(n) over n stable datapoints */
+        required_cv = ci_width * sqrt(min_datapoints) / (2 * TEST_MEAS_CI_Z);
+    }
+
     return te_meas_stats_init(meas_stats,
-                              TEST_MEAS_MAX_NUM_DATAPOINTS,
+                              max_datapoints,
                               TEST_MEAS_INIT_FLAGS,
-                              TEST_MEAS_MIN_NUM_DATAPOINTS,
-                              TEST_MEAS_REQUIRED_CV,
+                              min_datapoints,
+                              required_cv,
                               TEST_MEAS_ALLOWED_SKIPS,
                               TEST_MEAS_DEVIATION_COEFF);
 }
 
+/**
+ * Log relative width of 95% confidence interval of the mean achieved
+ * by measurements.
+ *
+ * @param tool          Tool name
+ * @param meas_stats    Measurements statistics
+ * @param title         Title, "CI" is appended to it
+ */
+extern void
+test_log_meas_ci(const char *tool, const te_meas_stats_t *meas_stats,
+                 const char *title)
+{
+    te_mi_logger *logger;
+    double ci_width;
+
+    if (meas_stats->data.num_datapoints == 0 || meas_stats->data.mean == 0)
+        return;
+
+    ci_width = 2 * TEST_MEAS_CI_Z * meas_stats->data.cv /
+               sqrt(meas_stats->data.num_datapoints);
+
+    RING("%s: 95%% confidence interval relative width %.4f over %u "
+         "datapoints", title, ci_width, meas_stats->data.num_datapoints);
+
+    if (te_mi_logger_meas_create(tool, &logger) != 0)
+        return;
+
+    te_mi_logger_add_comment(logger, NULL, title, "CI width %.4f over %u "
+                             "datapoints", ci_width,
+                             meas_stats->data.num_datapoints);
+    te_mi_logger_destroy(logger);
+}
+
+/**
+ * Log rates like tapi_dpdk_stats_log_rates() together with achieved
+ * confidence interval of the mean.
+ */
+extern void
+test_stats_log_rates(const char *tool, const te_meas_stats_t *meas_stats,
+                     unsigned int packet_size, unsigned int link_speed,
+                     const char *title)
+{
+    tapi_dpdk_stats_log_rates(tool, meas_stats, packet_size, link_speed,
+                              title);
+    test_log_meas_ci(tool, meas_stats, title);
+}
+
+/** Default allowed deviation below performance baseline, percents */
+#define TEST_PERF_BASELINE_DEF_TOLERANCE 5.0
+
+/**
+ * Compare measured rate with performance baseline. Baselines are read from
+ * the file specified by TE_PERF_BASELINES environment variable (by default
+ * perf-baselines.txt next to TRC database). Each line of the file is
+ *
+ * @code
+ * <test> <TRC tag> <packet size> <cores> <rate, Mpps> [<tolerance, %>]
+ * @endcode
+ *
+ * where TRC tag or packet size or cores may be @c * to match any. The first
+ * matching line with TRC tag set for the current run is used.
+ *
+ * @param test_name         Test name, e.g. TE_TEST_NAME
+ * @param packet_size       Packet size
+ * @param n_cores           The number of forwarding cores
+ * @param rate_pps          Measured rate, packets per second
+ * @param[out] deficit      How much the rate is below the baseline beyond
+ *                          the tolerance, percents
+ *
+ * @return @c TRUE if the rate is below baseline beyond the tolerance.
+ */
+extern te_bool
+test_perf_below_baseline(const char *test_name, unsigned int packet_size,
+                         unsigned int n_cores, double rate_pps,
+                         double *deficit)
+{
+    const char *path = getenv("TE_PERF_BASELINES");
+    te_bool below = FALSE;
+    char line[512];
+    FILE *f;
+
+    if (path == NULL || *path == '\0')
+        return FALSE;
+
+    f = fopen(path, "r");
+    if (f == NULL)
+    {
+        WARN("Failed to open performance baselines file %s", path);
+        return FALSE;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char test[128];
+        char tag[128];
+        char size[16];
+        char cores[16];
+        double baseline_mpps;
+        double tolerance = TEST_PERF_BASELINE_DEF_TOLERANCE;
+        int n;
+
+        if (line[0] == '#')
+            continue;
+
+        n = sscanf(line, "%127s %127s %15s %15s %lf %lf", test, tag, size,
+                   cores, &baseline_mpps, &tolerance);
+        if (n < 5)
+            continue;
+
+        if (strcmp(test, test_name) != 0 ||
+            (strcmp(size, "*") != 0 &&
+             strtoul(size, NULL, 10) != packet_size) ||
+            (strcmp(cores, "*") != 0 &&
+             strtoul(cores, NULL, 10) != n_cores) ||
+            (strcmp(tag, "*") != 0 &&
+             cfg_find_fmt(NULL, "/local:/trc_tags:%s", tag) != 0))
+            continue;
+
+        *deficit = 100.0 * (1.0 - rate_pps / (baseline_mpps * 1000000.0));
+        RING("Baseline for TRC tag '%s' is %.3f Mpps, measured %.3f Mpps "
+             "(%+.1f%%), tolerance %.1f%%", tag, baseline_mpps,
+             rate_pps / 1000000.0, -*deficit, tolerance);
+        below = (*deficit > tolerance);
+        break;
+    }
+
+    fclose(f);
+
+    return below;
+}
+
+/** Ethernet FCS, preamble, SFD and IPG size added to packet on wire */
+#define TEST_ETHER_WIRE_OVERHEAD 24
+
+/**
+ * IUT rate to traffic generator capacity ratio starting from which the
+ * generator is considered the bottleneck
+ */
+#define TEST_GENERATOR_SATURATION_RATIO 0.98
+
+/**
+ * The number of IUT testpmd cores and Rx queues used to sink traffic while
+ * traffic generator capacity is measured. Drops on IUT do not matter since
+ * generator Tx rate is measured.
+ */
+#define TEST_CALIBRATE_SINK_CORES 1
+
+/**
+ * Measure traffic generator Tx capacity. testpmd generator is run with
+ * the same parameters as in the test itself while IUT ports are kept up
+ * by testpmd receiving traffic in rxonly mode. Calibration fails if the
+ * generator link is down or nothing is transmitted.
+ *
+ * @param rpcs              RPC server to run the generator on
+ * @param iut_rpcs          RPC server to run the traffic sink on
+ * @param env               Environment
+ * @param n_cores           The number of generator cores
+ * @param prop              Generator cores properties
+ * @param gen_params        Generator parameters
+ * @param test_params       Test parameters
+ * @param n_ports           The number of ports used by the generator
+ * @param packet_size       Packet size without FCS
+ * @param[out] capacity_pps Aggregate generator Tx rate, packets per second
+ */
+extern te_errno
+test_calibrate_generator(rcf_rpc_server *rpcs, rcf_rpc_server *iut_rpcs,
+                         tapi_env *env, unsigned int n_cores,
+                         tapi_cpu_prop_t *prop, te_kvpair_h *gen_params,
+                         const te_kvpair_h *test_params,
+                         unsigned int n_ports, unsigned int packet_size,
+                         double *capacity_pps)
+{
+    tapi_dpdk_testpmd_job_t sink_job = {0};
+    tapi_dpdk_testpmd_job_t job = {0};
+    te_kvpair_h *sink_params = NULL;
+    te_meas_stats_t stats[TEST_MAX_IUT_PORTS] = {0};
+    unsigned int ports[TEST_MAX_IUT_PORTS] = {0};
+    unsigned int link_speeds[TEST_MAX_IUT_PORTS] = {0};
+    unsigned int n_found = 0;
+    unsigned int port;
+    te_errno rc;
+
+    *capacity_pps = 0;
+
+    if (n_ports > TEST_MAX_IUT_PORTS)
+        return TE_RC(TE_TAPI, TE_EINVAL);
+
+    rc = test_create_traffic_receiver_params(TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                             TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                             TEST_CALIBRATE_SINK_CORES,
+                                             packet_size, &sink_params);
+    if (rc == 0)
+    {
+        rc = tapi_dpdk_create_testpmd_job(iut_rpcs, env,
+                                          TEST_CALIBRATE_SINK_CORES, prop,
+                                          sink_params, &sink_job);
+    }
+    if (rc == 0)
+        rc = tapi_dpdk_testpmd_start(&sink_job);
+
+    if (rc == 0)
+    {
+        rc = tapi_dpdk_create_testpmd_job(rpcs, env, n_cores, prop,
+                                          gen_params, &job);
+    }
+
+    for (port = 0; port < n_ports && rc == 0; port++)
+        rc = test_meas_stats_init(test_params, &stats[port]);
+
+    if (rc == 0)
+        rc = tapi_dpdk_testpmd_start(&job);
+    if (rc == 0)
+    {
+        rc = tapi_dpdk_testpmd_get_link_speed_many_ports(&job, n_ports,
+                                                         &n_found, ports,
+                                                         link_speeds);
+        if (rc != 0 || n_found != n_ports)
+        {
+            ERROR("Traffic generator link is down, %u of %u ports are up",
+                  n_found, n_ports);
+            rc = TE_RC(TE_TAPI, TE_ENETDOWN);
+        }
+    }
+    if (rc == 0)
+    {
+        rc = tapi_dpdk_testpmd_get_stats_many_ports(&job, n_ports, &n_found,
+                                                    ports, stats, NULL);
+    }
+
+    for (port = 0; port < n_ports; port++)
+    {
+        *capacity_pps += stats[port].data.mean;
+        te_meas_stats_free(&stats[port]);
+    }
+
+    tapi_dpdk_testpmd_destroy(&job);
+    tapi_dpdk_testpmd_destroy(&sink_job);
+    if (sink_params != NULL)
+    {
+        te_kvpair_fini(sink_params);
+        free(sink_params);
+    }
+
+    if (rc == 0 && *capacity_pps <= 0)
+    {
+        ERROR("Traffic generator does not transmit anything");
+        rc = TE_RC(TE_TAPI, TE_EFAIL);
+    }
+
+    if (rc == 0)
+        RING("Traffic generator capacity is %.3f Mpps", *capacity_pps / 1e6);
+
+    return rc;
+}
+
+/**
+ * Log IUT rate as a fraction of traffic generator capacity and check if
+ * the generator is the bottleneck, i.e. it does not reach line rate and
+ * IUT handles almost everything it generates. The result is logged in
+ * MI comments rather than as a verdict since it describes the test setup
+ * and not IUT.
+ *
+ * @param tool          Tool name
+ * @param capacity_pps  Generator capacity, packets per second
+ * @param iut_pps       IUT rate, packets per second
+ * @param link_speed    Aggregate link speed, Mbps
+ * @param packet_size   Packet size without FCS
+ *
+ * @return @c TRUE if the generator is the bottleneck.
+ */
+extern te_bool
+test_generator_is_bottleneck(const char *tool, double capacity_pps,
+                             double iut_pps, unsigned int link_speed,
+                             unsigned int packet_size)
+{
+    double line_rate_pps = (double)link_speed * 1000000 / 8 /
+                           (packet_size + TEST_ETHER_WIRE_OVERHEAD);
+    double fraction;
+    te_bool bottleneck;
+    te_mi_logger *logger;
+
+    if (capacity_pps <= 0)
+        return FALSE;
+
+    fraction = iut_pps / capacity_pps;
+    bottleneck =
+        capacity_pps < line_rate_pps * TEST_GENERATOR_SATURATION_RATIO &&
+        fraction >= TEST_GENERATOR_SATURATION_RATIO;
+    RING("IUT rate is %.1f%% of traffic generator capacity %.3f Mpps, "
+         "line rate is %.3f Mpps%s", fraction * 100, capacity_pps / 1e6,
+         line_rate_pps / 1e6,
+         bottleneck ? ", traffic generator is the bottleneck" : "");
+
+    if (te_mi_logger_meas_create(tool, &logger) == 0)
+    {
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "GenCapacity",
+                              TE_MI_MEAS_AGGR_SINGLE, capacity_pps,
+                              TE_MI_MEAS_MULTIPLIER_PLAIN);
+        te_mi_logger_add_comment(logger, NULL, "GenCapacityFraction",
+                                 "%.4f", fraction);
+        te_mi_logger_add_comment(logger, NULL, "GenBottleneck", "%s",
+                                 bottleneck ? "yes" : "no");
+        te_mi_logger_destroy(logger);
+    }
+
+    return bottleneck;
+}
+
+/** Timeout to wait for a shell command run on an agent */
+#define TEST_AGENT_CMD_TIMEOUT_MS 10000
+
+/**
+ * Run shell command on the agent and wait for its successful completion.
+ *
+ * @param rpcs          RPC server to run the command with
+ * @param fmt           Command format string
+ *
+ * @return Status code.
+ */
+extern te_errno
+test_run_agent_cmd(rcf_rpc_server *rpcs, const char *fmt, ...)
+{
+    tapi_job_factory_t *factory = NULL;
+    tapi_job_t *job = NULL;
+    tapi_job_status_t status;
+    te_string cmd = TE_STRING_INIT;
+    va_list ap;
+    te_errno rc;
+
+    va_start(ap, fmt);
+    rc = te_string_append_va(&cmd, fmt, ap);
+    va_end(ap);
+    if (rc != 0)
+        goto out;
+
+    rc = tapi_job_factory_rpc_create(rpcs, &factory);
+    if (rc != 0)
+        goto out;
+
+    rc = tapi_job_simple_create(factory,
+            &(tapi_job_simple_desc_t){
+                .program = "sh",
+                .argv = (const char *[]){ "sh", "-c", cmd.ptr, NULL },
+                .job_loc = &job,
+                .filters = TAPI_JOB_SIMPLE_FILTERS(
+                    {.use_stderr = TRUE, .log_level = TE_LL_WARN}
+                )
+            });
+    if (rc == 0)
+        rc = tapi_job_start(job);
+    if (rc == 0)
+        rc = tapi_job_wait(job, TEST_AGENT_CMD_TIMEOUT_MS, &status);
+    if (rc == 0 && (status.type != TAPI_JOB_STATUS_EXITED ||
+                    status.value != 0))
+    {
+        ERROR("Command '%s' failed on %s", cmd.ptr, rpcs->ta);
+        rc = TE_RC(TE_TAPI, TE_EFAIL);
+    }
+
+out:
+    if (job != NULL)
+        (void)tapi_job_destroy(job, -1);
+    tapi_job_factory_destroy(factory);
+    te_string_free(&cmd);
+
+    return rc;
+}
+
+/** Timeout to wait for testpmd to stop and print forwarding statistics */
+#define TEST_TESTPMD_STOP_TIMEOUT_MS 10000
+
+/**
+ * Add testpmd option without value if it is supported.
+ *
+ * @param rpcs          RPC server to check the option support on
+ * @param env           Environment
+ * @param params        testpmd parameters to add the option to
+ * @param name          Option parameter name
+ * @param[out] supp     Whether the option is supported
+ */
+extern te_errno
+test_add_testpmd_opt_if_supported(rcf_rpc_server *rpcs, tapi_env *env,
+                                  te_kvpair_h *params, const char *name,
+                                  te_bool *supp)
+{
+    te_kvpair_h opt;
+    te_errno rc;
+
+    te_kvpair_init(&opt);
+    rc = te_kvpair_add(&opt, name, "TRUE");
+    if (rc == 0)
+        rc = tapi_dpdk_testpmd_is_opt_supported(rpcs, env, &opt, supp);
+    te_kvpair_fini(&opt);
+
+    if (rc != 0 || !*supp)
+        return rc;
+
+    return te_kvpair_add(params, name, "TRUE");
+}
+
+/**
+ * Add testpmd option to record forwarding cores cycles if it is supported.
+ *
+ * @param rpcs          RPC server to check the option support on
+ * @param env           Environment
+ * @param params        testpmd parameters to add the option to
+ * @param[out] supp     Whether the option is supported
+ */
+extern te_errno
+test_add_record_core_cycles(rcf_rpc_server *rpcs, tapi_env *env,
+                            te_kvpair_h *params, te_bool *supp)
+{
+    return test_add_testpmd_opt_if_supported(rpcs, env, params,
+                                             TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                             "record_core_cycles", supp);
+}
+
+/**
+ * Add testpmd option to record Rx/Tx burst sizes if it is supported.
+ *
+ * @param rpcs          RPC server to check the option support on
+ * @param env           Environment
+ * @param params        testpmd parameters to add the option to
+ * @param[out] supp     Whether the option is supported
+ */
+extern te_errno
+test_add_record_burst_stats(rcf_rpc_server *rpcs, tapi_env *env,
+                            te_kvpair_h *params, te_bool *supp)
+{
+    return test_add_testpmd_opt_if_supported(rpcs, env, params,
+                                             TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                             "record_burst_stats", supp);
+}
+
+/**
+ * Stop testpmd job gracefully to make it print forwarding statistics.
+ * The job must not be used for measurements after that.
+ *
+ * @param job           testpmd job
+ */
+extern te_errno
+test_stop_testpmd(tapi_dpdk_testpmd_job_t *job)
+{
+    te_errno rc;
+
+    /* testpmd prints forwarding statistics on exit by SIGINT */
+    rc = tapi_job_kill(job->job, SIGINT);
+    if (rc != 0)
+        return rc;
+
+    return tapi_job_wait(job->job, TEST_TESTPMD_STOP_TIMEOUT_MS, NULL);
+}
+
+/**
+ * Attach filter to extract CPU cycles per packet which testpmd prints
+ * in forwarding statistics when forwarding is stopped.
+ *
+ * @param job           testpmd job started with core cycles recording
+ * @param[out] filter   Attached filter
+ */
+extern te_errno
+test_attach_core_cycles_filter(tapi_dpdk_testpmd_job_t *job,
+                               tapi_job_channel_t **filter)
+{
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                "CPU cycles/packet", TRUE, 0, filter);
+    if (rc != 0)
+        return rc;
+
+    return tapi_job_filter_add_regexp(*filter,
+                                      "CPU cycles/packet=([0-9.]+)", 1);
+}
+
+/**
+ * Get CPU cycles per packet spent by forwarding cores of testpmd job
+ * stopped by test_stop_testpmd().
+ *
+ * @param filter        Filter attached by test_attach_core_cycles_filter()
+ * @param[out] cycles   CPU cycles per packet
+ */
+extern te_errno
+test_get_core_cycles_per_pkt(tapi_job_channel_t *filter, double *cycles)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_errno rc;
+
+    rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter),
+                          TEST_TESTPMD_STOP_TIMEOUT_MS, &buf);
+    if (rc == 0)
+        rc = te_strtod(buf.data.ptr, cycles);
+
+    te_string_free(&buf.data);
+
+    return rc;
+}
+
+/** Timeout to wait for burst mode printed by testpmd */
+#define TEST_BURST_MODE_TIMEOUT_MS 5000
+
+/**
+ * Attach filter to extract Rx/Tx burst modes which testpmd prints
+ * in queue information and request it for Rx and Tx queue 0 of port 0.
+ * Rx burst mode is extracted first.
+ *
+ * @param job           testpmd job which is not started yet
+ * @param[out] filter   Attached filter
+ */
+extern te_errno
+test_attach_burst_mode_filter(tapi_dpdk_testpmd_job_t *job,
+                              tapi_job_channel_t **filter)
+{
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                "Burst mode", TRUE, 0, filter);
+    if (rc != 0)
+        return rc;
+
+    rc = tapi_job_filter_add_regexp(*filter, "Burst mode: ([^\r\n]+)", 1);
+    if (rc != 0)
+        return rc;
+
+    te_string_append(&job->cmdline_setup, "show rxq info 0 0\n");
+    te_string_append(&job->cmdline_setup, "show txq info 0 0\n");
+
+    return 0;
+}
+
+/**
+ * Get the next burst mode extracted by test_attach_burst_mode_filter().
+ * Burst mode is not printed if the driver does not report it.
+ *
+ * @param filter        Attached filter
+ * @param[out] mode     Burst mode
+ */
+extern te_errno
+test_get_burst_mode(tapi_job_channel_t *filter, te_string *mode)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_errno rc;
+
+    rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter),
+                          TEST_BURST_MODE_TIMEOUT_MS, &buf);
+    if (rc == 0)
+        rc = te_string_append(mode, "%s", buf.data.ptr);
+
+    te_string_free(&buf.data);
+
+    return rc;
+}
+
+/**
+ * Attach filter to extract a cumulative port counter which testpmd prints
+ * in periodic port statistics, e.g. @c RX-nombuf or @c RX-missed.
+ *
+ * @param job           testpmd job started with statistics period
+ * @param name          Counter name as printed by testpmd
+ * @param[out] filter   Attached filter
+ */
+extern te_errno
+test_attach_port_counter_filter(tapi_dpdk_testpmd_job_t *job,
+                                const char *name,
+                                tapi_job_channel_t **filter)
+{
+    te_string re = TE_STRING_INIT;
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                name, TRUE, 0, filter);
+    if (rc != 0)
+        return rc;
+
+    te_string_append(&re, "%s: +([0-9]+)", name);
+    rc = tapi_job_filter_add_regexp(*filter, re.ptr, 1);
+    te_string_free(&re);
+
+    return rc;
+}
+
+/**
+ * Get a port counter summed up over all ports from the latest port
+ * statistics printed by testpmd. Statistics of all ports are printed
+ * one after another, so the last @p n_ports values are summed up.
+ *
+ * @param filter        Filter attached by test_attach_port_counter_filter()
+ * @param n_ports       The number of ports
+ * @param[out] value    Counter value
+ */
+extern te_errno
+test_get_port_counter(tapi_job_channel_t *filter, unsigned int n_ports,
+                      unsigned long long *value)
+{
+    unsigned long long *values;
+    unsigned int n_received = 0;
+    unsigned int i;
+    te_errno rc = 0;
+
+    values = calloc(n_ports, sizeof(*values));
+    if (values == NULL)
+        return TE_RC(TE_TAPI, TE_ENOMEM);
+
+    while (rc == 0)
+    {
+        tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+
+        rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter), 0, &buf);
+        if (rc == 0 && !buf.eos)
+            values[n_received++ % n_ports] = strtoull(buf.data.ptr, NULL, 10);
+
+        te_string_free(&buf.data);
+    }
+
+    *value = 0;
+    for (i = 0; i < n_ports; i++)
+        *value += values[i];
+    free(values);
+
+    if (n_received == 0)
+        return TE_RC(TE_TAPI, TE_ENODATA);
+
+    return 0;
+}
+
+/**
+ * Log a port counter printed by testpmd summed up over all ports.
+ *
+ * @param tool          Tool name
+ * @param filter        Filter attached by test_attach_port_counter_filter()
+ * @param n_ports       The number of ports
+ * @param title         Comment name
+ */
+extern void
+test_log_port_counter(const char *tool, tapi_job_channel_t *filter,
+                      unsigned int n_ports, const char *title)
+{
+    unsigned long long value;
+    te_mi_logger *logger;
+
+    if (test_get_port_counter(filter, n_ports, &value) != 0)
+    {
+        WARN("%s is not reported by testpmd", title);
+        return;
+    }
+
+    RING("%s: %llu", title, value);
+
+    if (te_mi_logger_meas_create(tool, &logger) != 0)
+        return;
+
+    te_mi_logger_add_comment(logger, NULL, title, "%llu", value);
+    te_mi_logger_destroy(logger);
+}
+
+/**
+ * Log CPU cycles per packet as MI measurement.
+ *
+ * @param tool          Tool name
+ * @param cycles        CPU cycles per packet
+ * @param title         Measurement name
+ */
+extern void
+test_log_core_cycles(const char *tool, double cycles, const char *title)
+{
+    te_mi_logger *logger;
+
+    RING("%s CPU cycles/packet: %.2f", title, cycles);
+
+    if (te_mi_logger_meas_create(tool, &logger) != 0)
+        return;
+
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_CPU, title,
+                          TE_MI_MEAS_AGGR_SINGLE, cycles,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_comment(logger, NULL, "units", "cycles/packet");
+    te_mi_logger_destroy(logger);
+}
+
+/**
+ * Attach filter to extract burst sizes distribution which testpmd prints
+ * for each forwarding stream (or port if there is one stream per port)
+ * when forwarding is stopped, e.g. "RX-bursts : 100 [75% of 32 pkts +
+ * 25% of 16 pkts]".
+ *
+ * @param job           testpmd job started with burst stats recording
+ * @param rx            Rx bursts if @c TRUE, Tx bursts otherwise
+ * @param[out] filter   Attached filter
+ */
+extern te_errno
+test_attach_burst_stats_filter(tapi_dpdk_testpmd_job_t *job, te_bool rx,
+                               tapi_job_channel_t **filter)
+{
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                rx ? "RX-bursts" : "TX-bursts", TRUE, 0,
+                                filter);
+    if (rc != 0)
+        return rc;
+
+    return tapi_job_filter_add_regexp(*filter,
+                                      rx ? "RX-bursts : ([0-9]+ \\[.*\\])" :
+                                           "TX-bursts : ([0-9]+ \\[.*\\])",
+                                      1);
+}
+
+/**
+ * Log burst sizes distribution of each forwarding stream of testpmd job
+ * stopped by test_stop_testpmd() as MI comments.
+ *
+ * @param tool          Tool name
+ * @param filter        Filter attached by test_attach_burst_stats_filter()
+ * @param title         Title, stream index is appended to it
+ */
+extern te_errno
+test_log_burst_stats(const char *tool, tapi_job_channel_t *filter,
+                     const char *title)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_string name = TE_STRING_INIT;
+    te_mi_logger *logger;
+    unsigned int n_streams = 0;
+    te_errno rc;
+
+    rc = te_mi_logger_meas_create(tool, &logger);
+    if (rc != 0)
+        return rc;
+
+    while ((rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter),
+                                  TEST_TESTPMD_STOP_TIMEOUT_MS,
+                                  &buf)) == 0 && !buf.eos)
+    {
+        te_string_reset(&name);
+        te_string_append(&name, "%s%u", title, n_streams);
+        RING("%s: %s", te_string_value(&name), buf.data.ptr);
+        te_mi_logger_add_comment(logger, NULL, te_string_value(&name), "%s",
+                                 buf.data.ptr);
+        n_streams++;
+        te_string_reset(&buf.data);
+    }
+
+    te_string_free(&name);
+    te_string_free(&buf.data);
+    te_mi_logger_destroy(logger);
+
+    /* Failure to get the next distribution is expected at the end */
+    return n_streams == 0 ? rc : 0;
+}
+
+/**
+ * Script installed to the agent directory which reads ethdev statistics
+ * from telemetry socket of a running DPDK application
+ */
+#define TEST_TELEMETRY_SCRIPT "dpdk-telemetry-stats.py"
+
+/** Timeout to get a telemetry sample in addition to sampling interval */
+#define TEST_TELEMETRY_TIMEOUT_MS 5000
+
+/**
+ * Log non-zero extended statistics of ports of a running DPDK application
+ * read from its telemetry socket.
+ *
+ * @param factory       Job factory of the agent running the application
+ * @param script        Telemetry script path on the agent
+ * @param program       Application program name or its suffix
+ * @param ports         Comma-separated list of port IDs
+ */
+extern te_errno
+test_telemetry_log_xstats(tapi_job_factory_t *factory, const char *script,
+                          const char *program, const char *ports)
+{
+    tapi_job_t *job = NULL;
+    tapi_job_channel_t *xstats_filter = NULL;
+    tapi_job_status_t status;
+    te_errno rc;
+
+    rc = tapi_job_simple_create(factory,
+            &(tapi_job_simple_desc_t){
+                .program = "python3",
+                .argv = (const char *[]){
+                    "python3", script, program, "xstats", ports, NULL
+                },
+                .job_loc = &job,
+                .filters = TAPI_JOB_SIMPLE_FILTERS(
+                    {.use_stdout = TRUE, .filter_name = "xstats",
+                     .re = "^xstat [0-9]+ [^ ]+ [1-9][0-9]*$",
+                     .log_level = TE_LL_RING,
+                     .filter_var = &xstats_filter},
+                    {.use_stderr = TRUE, .log_level = TE_LL_WARN}
+                )
+            });
+    if (rc == 0)
+        rc = tapi_job_start(job);
+    if (rc == 0)
+        rc = tapi_job_wait(job, TEST_TELEMETRY_TIMEOUT_MS, &status);
+    if (rc == 0 && (status.type != TAPI_JOB_STATUS_EXITED ||
+                    status.value != 0))
+    {
+        ERROR("Failed to get extended statistics of %s from telemetry "
+              "socket", program);
+        rc = TE_RC(TE_TAPI, TE_EFAIL);
+    }
+
+    if (job != NULL)
+        (void)tapi_job_destroy(job, -1);
+
+    return rc;
+}
+
+/**
+ * Get Rx and Tx packet rates of ports of running DPDK application by
+ * sampling ethdev statistics from its telemetry socket.
+ *
+ * @param rpcs          RPC server of the agent running the application
+ * @param program       Application program name or its suffix
+ *                      (e.g. @c testpmd matches @c dpdk-testpmd),
+ *                      exactly one such process must be running
+ * @param interval_ms   Sampling interval, milliseconds
+ * @param n_ports       The number of ports
+ * @param port_ids      Port IDs
+ * @param tx            Tx statistics per port or @c NULL
+ * @param rx            Rx statistics per port or @c NULL
+ */
+extern te_errno
+test_telemetry_get_stats_ports(rcf_rpc_server *rpcs, const char *program,
+                               unsigned int interval_ms, unsigned int n_ports,
+                               const unsigned int *port_ids,
+                               te_meas_stats_t *tx, te_meas_stats_t *rx)
+{
+    tapi_job_factory_t *factory = NULL;
+    tapi_job_t *job = NULL;
+    tapi_job_channel_t *sample_filter = NULL;
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_string ports = TE_STRING_INIT;
+    te_string interval = TE_STRING_INIT;
+    te_string script = TE_STRING_INIT;
+    char *agent_dir = NULL;
+    double *prev_time = NULL;
+    unsigned long long *prev_rx = NULL;
+    unsigned long long *prev_tx = NULL;
+    te_bool more = TRUE;
+    unsigned int port_id;
+    unsigned int port;
+    te_errno rc;
+
+    for (port = 0; port < n_ports; port++)
+    {
+        te_string_append(&ports, "%s%u", port == 0 ? "" : ",",
+                         port_ids[port]);
+    }
+    te_string_append(&interval, "%u", interval_ms);
+
+    prev_time = tapi_calloc(n_ports, sizeof(*prev_time));
+    prev_rx = tapi_calloc(n_ports, sizeof(*prev_rx));
+    prev_tx = tapi_calloc(n_ports, sizeof(*prev_tx));
+
+    rc = cfg_get_string(&agent_dir, "/agent:%s/dir:", rpcs->ta);
+    if (rc == 0)
+    {
+        te_string_append(&script, "%s/%s", agent_dir, TEST_TELEMETRY_SCRIPT);
+        rc = tapi_job_factory_rpc_create(rpcs, &factory);
+    }
+    if (rc == 0)
+    {
+        rc = tapi_job_simple_create(factory,
+                &(tapi_job_simple_desc_t){
+                    .program = "python3",
+                    .argv = (const char *[]){
+                        "python3", script.ptr, program, interval.ptr,
+                        ports.ptr, NULL
+                    },
+                    .job_loc = &job,
+                    .filters = TAPI_JOB_SIMPLE_FILTERS(
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = "^port [0-9]+ .*$", .extract = 0,
+                         .filter_var = &sample_filter},
+                        {.use_stderr = TRUE, .log_level = TE_LL_WARN}
+                    )
+                });
+    }
+    if (rc == 0)
+        rc = tapi_job_start(job);
+
+    while (rc == 0 && more)
+    {
+        double cur_time;
+        unsigned long long cur_rx;
+        unsigned long long cur_tx;
+
+        te_string_reset(&buf.data);
+        rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(sample_filter),
+                              interval_ms * 10 + TEST_TELEMETRY_TIMEOUT_MS,
+                              &buf);
+        if (rc != 0)
+            break;
+        if (buf.eos)
+        {
+            rc = TE_RC(TE_TAPI, TE_ENODATA);
+            break;
+        }
+
+        port = n_ports;
+        if (sscanf(buf.data.ptr, "port %u time %lf ipackets %llu "
+                   "opackets %llu", &port_id, &cur_time, &cur_rx,
+                   &cur_tx) == 4)
+        {
+            for (port = 0; port < n_ports; port++)
+            {
+                if (port_ids[port] == port_id)
+                    break;
+            }
+        }
+        if (port == n_ports)
+        {
+            ERROR("Unexpected telemetry sample '%s'", buf.data.ptr);
+            rc = TE_RC(TE_TAPI, TE_EINVAL);
+            break;
+        }
+
+        if (prev_time[port] != 0 && cur_time > prev_time[port])
+        {
+            double dt = cur_time - prev_time[port];
+
+            if (rx != NULL &&
+                te_meas_stats_update(&rx[port],
+                                     (cur_rx - prev_rx[port]) / dt) ==
+                TE_MEAS_STATS_UPDATE_NOMEM)
+                rc = TE_RC(TE_TAPI, TE_ENOMEM);
+            if (tx != NULL &&
+                te_meas_stats_update(&tx[port],
+                                     (cur_tx - prev_tx[port]) / dt) ==
+                TE_MEAS_STATS_UPDATE_NOMEM)
+                rc = TE_RC(TE_TAPI, TE_ENOMEM);
+        }
+        prev_time[port] = cur_time;
+        prev_rx[port] = cur_rx;
+        prev_tx[port] = cur_tx;
+
+        more = FALSE;
+        for (port = 0; port < n_ports; port++)
+        {
+            if ((rx != NULL && te_meas_stats_continue(&rx[port])) ||
+                (tx != NULL && te_meas_stats_continue(&tx[port])))
+                more = TRUE;
+        }
+    }
+
+    if (job != NULL)
+    {
+        (void)tapi_job_kill(job, SIGTERM);
+        (void)tapi_job_destroy(job, -1);
+    }
+
+    if (rc == 0)
+        rc = test_telemetry_log_xstats(factory, script.ptr, program,
+                                       ports.ptr);
+
+    tapi_job_factory_destroy(factory);
+    te_string_free(&buf.data);
+    te_string_free(&ports);
+    te_string_free(&interval);
+    te_string_free(&script);
+    free(agent_dir);
+    free(prev_time);
+    free(prev_rx);
+    free(prev_tx);
+
+    return rc;
+}
+
+/**
+ * Same as test_telemetry_get_stats_ports() for ports with IDs from 0 to
+ * @p n_ports - 1.
+ */
+extern te_errno
+test_telemetry_get_stats_many_ports(rcf_rpc_server *rpcs,
+                                    const char *program,
+                                    unsigned int interval_ms,
+                                    unsigned int n_ports,
+                                    te_meas_stats_t *tx, te_meas_stats_t *rx)
+{
+    unsigned int *port_ids = tapi_calloc(n_ports, sizeof(*port_ids));
+    unsigned int port;
+    te_errno rc;
+
+    for (port = 0; port < n_ports; port++)
+        port_ids[port] = port;
+
+    rc = test_telemetry_get_stats_ports(rpcs, program, interval_ms, n_ports,
+                                        port_ids, tx, rx);
+    free(port_ids);
+
+    return rc;
+}
+
+/**
+ * Get testpmd Rx and Tx statistics. If TE_TELEMETRY_STATS_INTERVAL
+ * environment variable is set (run.sh --telemetry-stats), statistics are
+ * sampled from the telemetry socket with the interval in milliseconds it
+ * specifies, parsing of testpmd output is a fallback.
+ *
+ * Parameters are the same as for tapi_dpdk_testpmd_get_stats_many_ports()
+ * plus RPC server of the agent running testpmd and test parameters used
+ * to reinitialize statistics on fallback.
+ */
+extern te_errno
+test_testpmd_get_stats_many_ports(rcf_rpc_server *rpcs,
+                                  const te_kvpair_h *params,
+                                  tapi_dpdk_testpmd_job_t *job,
+                                  unsigned int n_ports,
+                                  unsigned int *n_ports_found,
+                                  unsigned int *ports,
+                                  te_meas_stats_t *tx, te_meas_stats_t *rx)
+{
+    const char *interval_str = getenv("TE_TELEMETRY_STATS_INTERVAL");
+    unsigned int interval_ms;
+    unsigned int i;
+    te_errno rc;
+
+    if (interval_str != NULL &&
+        te_strtoui(interval_str, 0, &interval_ms) == 0 && interval_ms > 0)
+    {
+        rc = test_telemetry_get_stats_many_ports(rpcs, "testpmd",
+                                                 interval_ms, n_ports,
+                                                 tx, rx);
+        if (rc == 0)
+        {
+            *n_ports_found = n_ports;
+            for (i = 0; i < n_ports; i++)
+                ports[i] = i;
+
+            return 0;
+        }
+
+        WARN("Failed to get statistics from telemetry socket: %r, "
+             "fall back to testpmd output", rc);
+        for (i = 0; i < n_ports; i++)
+        {
+            if (rx != NULL)
+            {
+                te_meas_stats_free(&rx[i]);
+                rc = test_meas_stats_init(params, &rx[i]);
+                if (rc != 0)
+                    return rc;
+            }
+            if (tx != NULL)
+            {
+                te_meas_stats_free(&tx[i]);
+                rc = test_meas_stats_init(params, &tx[i]);
+                if (rc != 0)
+                    return rc;
+            }
+        }
+    }
+
+    return tapi_dpdk_testpmd_get_stats_many_ports(job, n_ports, n_ports_found,
+                                                  ports, tx, rx);
+}
+
+/**
+ * Attach filter to get forwarding lcores which testpmd or l2fwd reports on
+ * forwarding start. Must be called before the job is started.
+ *
+ * @param out_ch        Output channel of the job
+ * @param[out] filter   Forwarding lcores filter
+ */
+extern te_errno
+test_attach_fwd_lcores_filter(tapi_job_channel_t *out_ch,
+                              tapi_job_channel_t **filter)
+{
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(out_ch),
+                                "Forwarding lcores", TRUE, 0, filter);
+    if (rc != 0)
+        return rc;
+
+    return tapi_job_filter_add_regexp(*filter,
+                "^(?:Logical Core|Lcore) ([0-9]+)"
+                "(?: \\(socket [0-9]+\\) forwards|: RX port)", 1);
+}
+
+/**
+ * Get comma-separated list of forwarding lcores of running application.
+ * Lcore IDs are CPU IDs since applications are started with a list of CPUs.
+ *
+ * @param filter        Forwarding lcores filter
+ * @param cpus          String to append the list to
+ *
+ * @return Status code, @c TE_ENOENT if no lcores are reported.
+ */
+extern te_errno
+test_get_fwd_lcores(tapi_job_channel_t *filter, te_string *cpus)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    size_t start_len = cpus->len;
+
+    while (tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter), 0, &buf) == 0 &&
+           !buf.eos)
+    {
+        te_string_append(cpus, "%s%s", cpus->len == start_len ? "" : ",",
+                         buf.data.ptr);
+        te_string_reset(&buf.data);
+    }
+    te_string_free(&buf.data);
+
+    return cpus->len == start_len ? TE_RC(TE_TAPI, TE_ENOENT) : 0;
+}
+
+/** Duration of hardware performance counters collection, seconds */
+#define TEST_PERF_STAT_DURATION 10
+
+/** Hardware events counted by perf stat */
+enum test_perf_stat_event {
+    TEST_PERF_STAT_CYCLES,
+    TEST_PERF_STAT_INSTRUCTIONS,
+    TEST_PERF_STAT_LLC_LOADS,
+    TEST_PERF_STAT_LLC_LOAD_MISSES,
+    TEST_PERF_STAT_BRANCHES,
+    TEST_PERF_STAT_BRANCH_MISSES,
+    TEST_PERF_STAT_N_EVENTS,
+};
+
+/** perf stat names of events in the order of test_perf_stat_event */
+static const char *test_perf_stat_events[TEST_PERF_STAT_N_EVENTS] = {
+    "cycles",
+    "instructions",
+    "LLC-loads",
+    "LLC-load-misses",
+    "branches",
+    "branch-misses",
+};
+
+/** Hardware performance counters collector state */
+typedef struct test_perf_stat {
+    /** Collection is requested and has not failed so far */
+    te_bool enabled;
+    /** Filter to get forwarding lcores of the application */
+    tapi_job_channel_t *lcores_filter;
+    tapi_job_factory_t *factory;
+    tapi_job_t *job;
+    tapi_job_channel_t *out_chs[2];
+    /** Filters to get events counts in the order of test_perf_stat_event */
+    tapi_job_channel_t *filters[TEST_PERF_STAT_N_EVENTS];
+} test_perf_stat;
+
+/**
+ * Initialize hardware performance counters collector. Collection is
+ * enabled by TE_PERF_STAT=yes environment variable (run.sh --perf-stat).
+ *
+ * @param ps            Collector state
+ */
+extern void
+test_perf_stat_init(test_perf_stat *ps)
+{
+    const char *perf_stat = getenv("TE_PERF_STAT");
+
+    memset(ps, 0, sizeof(*ps));
+    ps->enabled = (perf_stat != NULL && strcmp(perf_stat, "yes") == 0);
+}
+
+/**
+ * Prepare to collect hardware performance counters on forwarding lcores
+ * of an application. Must be called before the application job is started.
+ *
+ * @param ps            Collector state
+ * @param out_ch        Output channel of the application job
+ */
+extern te_errno
+test_perf_stat_attach(test_perf_stat *ps, tapi_job_channel_t *out_ch)
+{
+    if (!ps->enabled)
+        return 0;
+
+    return test_attach_fwd_lcores_filter(out_ch, &ps->lcores_filter);
+}
+
+/**
+ * Start counting hardware events on forwarding lcores of running
+ * application.
+ * Collection is disabled with a warning if it cannot be started.
+ *
+ * @param ps            Collector state
+ * @param rpcs          RPC server of the agent running testpmd
+ */
+extern void
+test_perf_stat_start(test_perf_stat *ps, rcf_rpc_server *rpcs)
+{
+    te_string events = TE_STRING_INIT;
+    te_string cpus = TE_STRING_INIT;
+    te_string duration = TE_STRING_INIT;
+    unsigned int i;
+    te_errno rc;
+
+    if (!ps->enabled)
+        return;
+
+    if (test_get_fwd_lcores(ps->lcores_filter, &cpus) != 0)
+    {
+        WARN("Failed to get forwarding lcores, hardware performance "
+             "counters are not collected");
+        ps->enabled = FALSE;
+        goto out;
+    }
+
+    for (i = 0; i < TEST_PERF_STAT_N_EVENTS; i++)
+    {
+        te_string_append(&events, "%s%s", i == 0 ? "" : ",",
+                         test_perf_stat_events[i]);
+    }
+    te_string_append(&duration, "%u", TEST_PERF_STAT_DURATION);
+
+    rc = tapi_job_factory_rpc_create(rpcs, &ps->factory);
+    if (rc == 0)
+    {
+        rc = tapi_job_simple_create(ps->factory,
+                &(tapi_job_simple_desc_t){
+                    .program = "perf",
+                    .argv = (const char *[]){
+                        "perf", "stat", "-x", ",", "-e", events.ptr,
+                        "-C", cpus.ptr, "--", "sleep", duration.ptr, NULL
+                    },
+                    .job_loc = &ps->job,
+                    .stdout_loc = &ps->out_chs[0],
+                    .stderr_loc = &ps->out_chs[1],
+                    .filters = TAPI_JOB_SIMPLE_FILTERS(
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,cycles,", .extract = 1,
+                         .filter_var = &ps->filters[TEST_PERF_STAT_CYCLES]},
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,instructions,", .extract = 1,
+                         .filter_var =
+                            &ps->filters[TEST_PERF_STAT_INSTRUCTIONS]},
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,LLC-loads,", .extract = 1,
+                         .filter_var = &ps->filters[TEST_PERF_STAT_LLC_LOADS]},
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,LLC-load-misses,",
+                         .extract = 1,
+                         .filter_var =
+                            &ps->filters[TEST_PERF_STAT_LLC_LOAD_MISSES]},
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,branches,", .extract = 1,
+                         .filter_var = &ps->filters[TEST_PERF_STAT_BRANCHES]},
+                        {.use_stderr = TRUE, .readable = TRUE,
+                         .re = "^([0-9]+),[^,]*,branch-misses,", .extract = 1,
+                         .filter_var =
+                            &ps->filters[TEST_PERF_STAT_BRANCH_MISSES]},
+                        {.use_stderr = TRUE, .log_level = TE_LL_WARN}
+                    )
+                });
+    }
+    if (rc == 0)
+        rc = tapi_job_start(ps->job);
+
+    if (rc != 0)
+    {
+        WARN("Failed to start perf stat on CPUs %s, hardware performance "
+             "counters are not collected: %r", cpus.ptr, rc);
+        ps->enabled = FALSE;
+    }
+    else
+    {
+        RING("Collecting hardware performance counters on CPUs %s",
+             cpus.ptr);
+    }
+
+out:
+    te_string_free(&events);
+    te_string_free(&cpus);
+    te_string_free(&duration);
+}
+
+/**
+ * Get the count of a hardware event collected by perf stat.
+ *
+ * @return Event count or @c -1 if it is not supported.
+ */
+static double
+test_perf_stat_get_event(test_perf_stat *ps, enum test_perf_stat_event event)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    double value = -1;
+
+    if (tapi_job_receive(TAPI_JOB_CHANNEL_SET(ps->filters[event]), 0,
+                         &buf) != 0 || buf.eos ||
+        te_strtod(buf.data.ptr, &value) != 0)
+    {
+        WARN("Hardware event '%s' is not counted",
+             test_perf_stat_events[event]);
+        value = -1;
+    }
+    te_string_free(&buf.data);
+
+    return value;
+}
+
+/**
+ * Wait for hardware performance counters collection to finish and log
+ * IPC, LLC miss rate, branch miss rate and instructions per packet as MI
+ * measurements. Metrics which depend on events not supported by CPU
+ * (e.g. in a virtual machine) are skipped with a warning.
+ *
+ * @param ps            Collector state
+ * @param tool          Tool name
+ * @param pps           Packets per second processed by forwarding cores
+ * @param title         Title, metric name is appended to it
+ */
+extern void
+test_perf_stat_log(test_perf_stat *ps, const char *tool, double pps,
+                   const char *title)
+{
+    tapi_job_status_t status;
+    double counts[TEST_PERF_STAT_N_EVENTS];
+    te_string name = TE_STRING_INIT;
+    te_mi_logger *logger;
+    unsigned int i;
+    te_errno rc;
+
+    if (!ps->enabled)
+        return;
+
+    rc = tapi_job_wait(ps->job, (TEST_PERF_STAT_DURATION + 10) * 1000,
+                       &status);
+    if (rc != 0 || status.type != TAPI_JOB_STATUS_EXITED ||
+        status.value != 0)
+    {
+        WARN("perf stat failed, hardware performance counters are not "
+             "available");
+        return;
+    }
+
+    for (i = 0; i < TEST_PERF_STAT_N_EVENTS; i++)
+        counts[i] = test_perf_stat_get_event(ps, i);
+
+    if (te_mi_logger_meas_create(tool, &logger) != 0)
+        return;
+
+#define TEST_PERF_STAT_LOG_RATIO(_metric, _num, _den, _mult) \
+    do {                                                                \
+        if (counts[_num] >= 0 && counts[_den] > 0)                      \
+        {                                                               \
+            te_string_reset(&name);                                     \
+            te_string_append(&name, "%s%s", title, _metric);            \
+            RING("%s: %.4f", name.ptr,                                  \
+                 counts[_num] * (_mult) / counts[_den]);                \
+            te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_CPU,         \
+                                  name.ptr, TE_MI_MEAS_AGGR_SINGLE,     \
+                                  counts[_num] * (_mult) / counts[_den],\
+                                  TE_MI_MEAS_MULTIPLIER_PLAIN);         \
+        }                                                               \
+    } while (0)
+
+    TEST_PERF_STAT_LOG_RATIO("IPC", TEST_PERF_STAT_INSTRUCTIONS,
+                             TEST_PERF_STAT_CYCLES, 1);
+    TEST_PERF_STAT_LOG_RATIO("LLCMissRate", TEST_PERF_STAT_LLC_LOAD_MISSES,
+                             TEST_PERF_STAT_LLC_LOADS, 100);
+    TEST_PERF_STAT_LOG_RATIO("BranchMissRate", TEST_PERF_STAT_BRANCH_MISSES,
+                             TEST_PERF_STAT_BRANCHES, 100);
+
+#undef TEST_PERF_STAT_LOG_RATIO
+
+    if (counts[TEST_PERF_STAT_INSTRUCTIONS] >= 0 && pps > 0)
+    {
+        double instr_per_pkt = counts[TEST_PERF_STAT_INSTRUCTIONS] /
+                               (pps * TEST_PERF_STAT_DURATION);
+
+        te_string_reset(&name);
+        te_string_append(&name, "%sInstrPerPkt", title);
+        RING("%s: %.2f", name.ptr, instr_per_pkt);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_CPU, name.ptr,
+                              TE_MI_MEAS_AGGR_SINGLE, instr_per_pkt,
+                              TE_MI_MEAS_MULTIPLIER_PLAIN);
+    }
+
+    te_mi_logger_destroy(logger);
+    te_string_free(&name);
+}
+
+/**
+ * Release resources of hardware performance counters collector.
+ *
+ * @param ps            Collector state
+ */
+extern void
+test_perf_stat_fini(test_perf_stat *ps)
+{
+    if (ps->job != NULL)
+        (void)tapi_job_destroy(ps->job, -1);
+    tapi_job_factory_destroy(ps->factory);
+}
+
+/** Duration of forwarding cores profiling, seconds */
+#define TEST_PERF_RECORD_DURATION 10
+/** Profiling sampling frequency, Hz */
+#define TEST_PERF_RECORD_FREQ 999
+/** Timeout to wait for profiling data to be processed, milliseconds */
+#define TEST_PERF_RECORD_REPORT_TIMEOUT_MS 120000
+
+/**
+ * awk program folding call stacks printed by perf script -F comm,ip,sym
+ * into lines "comm;root;...;leaf count" accepted by flamegraph.pl.
+ * perf script prints a sample header line followed by call stack frames
+ * from leaf to root, one per indented line.
+ */
+#define TEST_PERF_RECORD_FOLD_AWK \
+    "function flush(   s, i) {\n"                                           \
+    "    if (!have) return\n"                                               \
+    "    s = comm\n"                                                        \
+    "    for (i = nf; i > 0; i--) s = s \";\" f[i]\n"                       \
+    "    n[s]++\n"                                                          \
+    "    have = 0; nf = 0\n"                                                \
+    "}\n"                                                                   \
+    "/^[^ \\t]/ { flush(); comm = $1; have = 1; next }\n"                   \
+    "NF > 0 { sub(/^[ \\t]*[0-9a-f]+ /, \"\"); f[++nf] = $0 }\n"            \
+    "END { flush(); for (s in n) print s, n[s] }\n"
+
+/** Forwarding cores profiler state */
+typedef struct test_perf_record {
+    /** Profiling is requested and has not failed so far */
+    te_bool enabled;
+    /** Filter to get forwarding lcores of the application */
+    tapi_job_channel_t *lcores_filter;
+    tapi_job_factory_t *factory;
+    tapi_job_t *job;
+    tapi_job_channel_t *out_chs[2];
+    /** Profiling data file on the agent */
+    te_string data_path;
+} test_perf_record;
+
+/**
+ * Initialize forwarding cores profiler. Profiling is enabled by
+ * TE_PERF_RECORD=yes environment variable (run.sh --perf-record).
+ *
+ * @param pr            Profiler state
+ */
+extern void
+test_perf_record_init(test_perf_record *pr)
+{
+    const char *perf_record = getenv("TE_PERF_RECORD");
+
+    memset(pr, 0, sizeof(*pr));
+    pr->data_path = (te_string)TE_STRING_INIT;
+    pr->enabled = (perf_record != NULL && strcmp(perf_record, "yes") == 0);
+}
+
+/**
+ * Prepare to profile forwarding lcores of an application. Must be called
+ * before the application job is started.
+ *
+ * @param pr            Profiler state
+ * @param out_ch        Output channel of the application job
+ */
+extern te_errno
+test_perf_record_attach(test_perf_record *pr, tapi_job_channel_t *out_ch)
+{
+    if (!pr->enabled)
+        return 0;
+
+    return test_attach_fwd_lcores_filter(out_ch, &pr->lcores_filter);
+}
+
+/**
+ * Start sampling call stacks on forwarding lcores of running application.
+ * Profiling is disabled with a warning if it cannot be started.
+ *
+ * @param pr            Profiler state
+ * @param rpcs          RPC server of the agent running the application
+ */
+extern void
+test_perf_record_start(test_perf_record *pr, rcf_rpc_server *rpcs)
+{
+    te_string cpus = TE_STRING_INIT;
+    te_string freq = TE_STRING_INIT;
+    te_string duration = TE_STRING_INIT;
+    te_errno rc;
+
+    if (!pr->enabled)
+        return;
+
+    if (test_get_fwd_lcores(pr->lcores_filter, &cpus) != 0)
+    {
+        WARN("Failed to get forwarding lcores, profiling is not done");
+        pr->enabled = FALSE;
+        goto out;
+    }
+
+    te_string_append(&pr->data_path, "/tmp/te_perf_%s_%d.data", rpcs->ta,
+                     (int)getpid());
+    te_string_append(&freq, "%u", TEST_PERF_RECORD_FREQ);
+    te_string_append(&duration, "%u", TEST_PERF_RECORD_DURATION);
+
+    rc = tapi_job_factory_rpc_create(rpcs, &pr->factory);
+    if (rc == 0)
+    {
+        rc = tapi_job_simple_create(pr->factory,
+                &(tapi_job_simple_desc_t){
+                    .program = "perf",
+                    .argv = (const char *[]){
+                        "perf", "record", "-g", "-F", freq.ptr,
+                        "-C", cpus.ptr, "-o", pr->data_path.ptr,
+                        "--", "sleep", duration.ptr, NULL
+                    },
+                    .job_loc = &pr->job,
+                    .stdout_loc = &pr->out_chs[0],
+                    .stderr_loc = &pr->out_chs[1],
+                    .filters = TAPI_JOB_SIMPLE_FILTERS(
+                        {.use_stderr = TRUE, .log_level = TE_LL_RING}
+                    )
+                });
+    }
+    if (rc == 0)
+        rc = tapi_job_start(pr->job);
+
+    if (rc != 0)
+    {
+        WARN("Failed to start perf record on CPUs %s, profiling is not "
+             "done: %r", cpus.ptr, rc);
+        pr->enabled = FALSE;
+    }
+    else
+    {
+        RING("Profiling forwarding CPUs %s", cpus.ptr);
+    }
+
+out:
+    te_string_free(&cpus);
+    te_string_free(&freq);
+    te_string_free(&duration);
+}
+
+/**
+ * Wait for profiling to finish, fold sampled call stacks on the agent and
+ * store them as an artifact in the logs directory. The folded stacks file
+ * has "frames count" lines and may be passed to flamegraph.pl directly.
+ *
+ * @param pr            Profiler state
+ * @param rpcs          RPC server of the agent running the application
+ * @param title         Title used in the artifact file name
+ */
+extern void
+test_perf_record_save(test_perf_record *pr, rcf_rpc_server *rpcs,
+                      const char *title)
+{
+    tapi_job_t *report_job = NULL;
+    tapi_job_status_t status;
+    te_string cmd = TE_STRING_INIT;
+    te_string folded_path = TE_STRING_INIT;
+    te_string local_path = TE_STRING_INIT;
+    const char *log_dir = getenv("TE_LOG_DIR");
+    te_errno rc;
+
+    if (!pr->enabled)
+        return;
+
+    rc = tapi_job_wait(pr->job, (TEST_PERF_RECORD_DURATION + 10) * 1000,
+                       &status);
+    if (rc != 0 || status.type != TAPI_JOB_STATUS_EXITED ||
+        status.value != 0)
+    {
+        WARN("perf record failed, profiling data is not available");
+        goto out;
+    }
+
+    te_string_append(&folded_path, "%s.folded", pr->data_path.ptr);
+    /* Script arguments are passed as positional parameters to avoid quoting */
+    te_string_append(&cmd, "set -o pipefail; "
+                     "perf script -i \"$1\" -F comm,ip,sym | "
+                     "awk \"$2\" > \"$3\"");
+
+    rc = tapi_job_simple_create(pr->factory,
+            &(tapi_job_simple_desc_t){
+                .program = "bash",
+                .argv = (const char *[]){
+                    "bash", "-c", cmd.ptr, "bash", pr->data_path.ptr,
+                    TEST_PERF_RECORD_FOLD_AWK, folded_path.ptr, NULL
+                },
+                .job_loc = &report_job,
+                .filters = TAPI_JOB_SIMPLE_FILTERS(
+                    {.use_stderr = TRUE, .log_level = TE_LL_RING}
+                )
+            });
+    if (rc == 0)
+        rc = tapi_job_start(report_job);
+    if (rc == 0)
+    {
+        rc = tapi_job_wait(report_job, TEST_PERF_RECORD_REPORT_TIMEOUT_MS,
+                           &status);
+    }
+    if (rc != 0 || status.type != TAPI_JOB_STATUS_EXITED ||
+        status.value != 0)
+    {
+        WARN("Failed to fold profiling call stacks");
+        goto out;
+    }
+
+    te_string_append(&local_path, "%s/perf_%s_%s_%d.folded",
+                     log_dir != NULL ? log_dir : ".", title, rpcs->ta,
+                     (int)getpid());
+    rc = rcf_ta_get_file(rpcs->ta, 0, folded_path.ptr, local_path.ptr);
+    if (rc != 0)
+    {
+        WARN("Failed to get folded call stacks from %s: %r", rpcs->ta, rc);
+        goto out;
+    }
+
+    TEST_ARTIFACT("%s profiling folded call stacks: %s", title,
+                  local_path.ptr);
+
+out:
+    if (report_job != NULL)
+        (void)tapi_job_destroy(report_job, -1);
+    if (folded_path.len != 0)
+        (void)rcf_ta_del_file(rpcs->ta, 0, folded_path.ptr);
+    (void)rcf_ta_del_file(rpcs->ta, 0, pr->data_path.ptr);
+    te_string_free(&cmd);
+    te_string_free(&folded_path);
+    te_string_free(&local_path);
+}
+
+/**
+ * Release resources of forwarding cores profiler.
+ *
+ * @param pr            Profiler state
+ */
+extern void
+test_perf_record_fini(test_perf_record *pr)
+{
+    if (pr->job != NULL)
+        (void)tapi_job_destroy(pr->job, -1);
+    tapi_job_factory_destroy(pr->factory);
+    te_string_free(&pr->data_path);
+}
+
 #endif
@@ -23,6 +23,7 @@
 #include <netinet/ip_icmp.h>
 #include <netinet/if_ether.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "dpdk_pmd_ts.h"
 #include "dpdk_pmd_test.h"
@@ -1159,6 +1160,8 @@ test_prepare_ethdev(struct test_ethdev_config *test_ethdev_config,
 
     test_ethdev_state cur_state;
     int               next_step;
+    struct timeval    tv_start;
+    struct timeval    tv_end;
 
     if (st < TEST_ETHDEV_UNINITIALIZED || st > TEST_ETHDEV_DETACHED)
         return TE_EINVAL;
@@ -1183,11 +1186,17 @@ test_prepare_ethdev(struct test_ethdev_config *test_ethdev_config,
         if (test_ethdev_config->closed)
             TEST_VERDICT("Unable to change device state after device close");
 
+        gettimeofday(&tv_start, NULL);
+
         if (next_step > 0)
             tapi_ethdev_states[cur_state].setup(test_ethdev_config);
         else
             tapi_ethdev_states[cur_state + 1].rollback(test_ethdev_config);
 
+        gettimeofday(&tv_end, NULL);
+
+        test_ethdev_config->transition_us[cur_state] =
+            TIMEVAL_SUB(tv_end, tv_start);
         test_ethdev_config->cur_state = cur_state;
     }
 
@@ -5571,7 +5580,7 @@ test_build_representor_dev_arg(unsigned int n_rep, const unsigned int *rep_ids,
 
     for (i = 0; i < n_rep; i++)
     {
-        te_string_append(&result, "%s%u%s", i == 0 ? "representor=[" : "",
+        te_string_append(&result, "%s%u%s", i == 0 ? "representor=[" : ",",
                          rep_ids[i], i == (n_rep - 1) ? "]" : "");
     }
 
@@ -6141,6 +6150,62 @@ out:
 
 }
 
+te_errno
+test_add_pci_fn_desc_lim(rcf_rpc_server *rpcs,
+                         const struct if_nameindex *port, te_bool rx,
+                         const struct tarpc_rte_eth_desc_lim *desc_lim)
+{
+    const char *dir = rx ? "rx" : "tx";
+    char prop[32];
+    te_errno rc;
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_max", dir);
+    rc = test_add_pci_fn_prop(rpcs, port, prop, desc_lim->nb_max);
+    if (rc != 0)
+        return rc;
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_min", dir);
+    rc = test_add_pci_fn_prop(rpcs, port, prop, desc_lim->nb_min);
+    if (rc != 0)
+        return rc;
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_align", dir);
+    return test_add_pci_fn_prop(rpcs, port, prop, desc_lim->nb_align);
+}
+
+te_errno
+test_get_pci_fn_desc_lim(rcf_rpc_server *rpcs,
+                         const struct if_nameindex *port, te_bool rx,
+                         struct tarpc_rte_eth_desc_lim *desc_lim)
+{
+    const char *dir = rx ? "rx" : "tx";
+    unsigned int value;
+    char prop[32];
+    te_errno rc;
+
+    memset(desc_lim, 0, sizeof(*desc_lim));
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_max", dir);
+    rc = test_get_pci_fn_prop(rpcs, port, prop, &value);
+    if (rc != 0)
+        return rc;
+    desc_lim->nb_max = value;
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_min", dir);
+    rc = test_get_pci_fn_prop(rpcs, port, prop, &value);
+    if (rc != 0)
+        return rc;
+    desc_lim->nb_min = value;
+
+    snprintf(prop, sizeof(prop), "%s_desc_nb_align", dir);
+    rc = test_get_pci_fn_prop(rpcs, port, prop, &value);
+    if (rc != 0)
+        return rc;
+    desc_lim->nb_align = value;
+
+    return 0;
+}
+
 void
 test_check_mtu(rcf_rpc_server *rpcs, const struct if_nameindex *port,
                unsigned int packet_size)
@@ -353,6 +353,9 @@ struct test_rx_mq {
     struct test_rx_mq_rss rss;
 };
 
+/** The number of Ethernet device states */
+#define TEST_ETHDEV_NB_STATES (TEST_ETHDEV_DETACHED + 1)
+
 /**
  * Information about the configuration of the Ethernet device
  */
@@ -398,6 +401,10 @@ struct test_ethdev_config {
     te_bool                       skip_link_up_check; /**< Do not check link
                                                            when going to STARTED
                                                            state */
+    long long                     transition_us[TEST_ETHDEV_NB_STATES];
+                                               /**< Duration of the last
+                                                    transition to each state
+                                                    (in microseconds) */
 };
 
 /** Test parameter to specify mbuf segmentation rules */
@@ -1773,6 +1780,36 @@ extern te_errno test_add_pci_fn_prop(rcf_rpc_server *rpcs,
                                      const struct if_nameindex *port,
                                      char *prop, unsigned int value);
 
+/**
+ * Add Rx or Tx descriptors number limits of the port to PCI function
+ * properties.
+ *
+ * @param rpcs      RPC server handle
+ * @param port      Port
+ * @param rx        Rx limits if @c TRUE, Tx limits otherwise
+ * @param desc_lim  Descriptors number limits
+ *
+ * @return Status code
+ */
+extern te_errno test_add_pci_fn_desc_lim(rcf_rpc_server *rpcs,
+                                const struct if_nameindex *port, te_bool rx,
+                                const struct tarpc_rte_eth_desc_lim *desc_lim);
+
+/**
+ * Get Rx or Tx descriptors number limits of the port added by
+ * test_add_pci_fn_desc_lim().
+ *
+ * @param rpcs          RPC server handle
+ * @param port          Port
+ * @param rx            Rx limits if @c TRUE, Tx limits otherwise
+ * @param[out] desc_lim Descriptors number limits
+ *
+ * @return Status code
+ */
+extern te_errno test_get_pci_fn_desc_lim(rcf_rpc_server *rpcs,
+                                const struct if_nameindex *port, te_bool rx,
+                                struct tarpc_rte_eth_desc_lim *desc_lim);
+
 /**
  * Skip the test if required packet size is out of MTU limitations
  * reported by the device and saved in local configuration tree.
@@ -55,6 +55,13 @@ main(int argc, char *argv[])
     te_meas_stats_t meas_stats_rx = {0};
     te_meas_stats_t tst_stats_tx = {0};
 
+    test_perf_record perf_record;
+    double gen_capacity;
+    te_bool gen_bottleneck;
+    double deficit;
+
+    test_perf_record_init(&perf_record);
+
     TEST_START;
     TEST_GET_PCO(iut_jobs_ctrl);
     TEST_GET_PCO(tst_jobs_ctrl);
@@ -80,6 +87,13 @@ main(int argc, char *argv[])
                            TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
                            "0,%s", iut_mac));
 
+    TEST_STEP("Measure traffic generator capacity running it on TST with "
+              "testpmd receiving traffic on IUT");
+    CHECK_RC(test_calibrate_generator(tst_jobs_ctrl, iut_jobs_ctrl, &env,
+                                      n_peer_cores, &prop,
+                                      traffic_generator_params, &test_params,
+                                      1, packet_size, &gen_capacity));
+
     TEST_STEP("Create l2fwd job");
     CHECK_RC(tapi_dpdk_create_l2fwd_job(iut_jobs_ctrl, &env, n_l2fwd_fwd_cores,
                                         &prop, &test_params, &l2fwd_job));
@@ -89,6 +103,8 @@ main(int argc, char *argv[])
                                           n_peer_cores,
                                           &prop, traffic_generator_params,
                                           &tst_testpmd_job));
+    CHECK_RC(test_perf_record_attach(&perf_record, l2fwd_job.out_chs[0]));
+
     TEST_STEP("Start L2fwd application");
     CHECK_RC(tapi_dpdk_l2fwd_start(&l2fwd_job));
 
@@ -98,10 +114,13 @@ main(int argc, char *argv[])
     TEST_STEP("Retrieve link speed from running testpmd");
     CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job, &link_speed));
 
+    TEST_STEP("Start profiling of IUT forwarding cores if requested");
+    test_perf_record_start(&perf_record, iut_jobs_ctrl);
+
     TEST_STEP("Initialize Tx and Rx statistics");
-    CHECK_RC(test_meas_stats_init(&meas_stats_tx));
-    CHECK_RC(test_meas_stats_init(&tst_stats_tx));
-    CHECK_RC(test_meas_stats_init(&meas_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_tx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+    CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_rx));
 
     TEST_STEP("Retrieve stats from running l2fwd");
     CHECK_RC(tapi_dpdk_l2fwd_get_stats(&l2fwd_job, &meas_stats_tx,
@@ -113,18 +132,35 @@ main(int argc, char *argv[])
     if (meas_stats_tx.data.mean == 0 || meas_stats_rx.data.mean == 0)
         TEST_VERDICT("Failure: zero Rx or Tx packets per second");
 
-    tapi_dpdk_stats_log_rates(TAPI_DPDK_L2FWD_NAME, &meas_stats_tx,
-                              packet_size, link_speed, "FwdTx");
+    test_stats_log_rates(TAPI_DPDK_L2FWD_NAME, &meas_stats_tx,
+                         packet_size, link_speed, "FwdTx");
+
+    test_stats_log_rates(TAPI_DPDK_L2FWD_NAME, &meas_stats_rx,
+                         packet_size, link_speed, "FwdRx");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         packet_size, link_speed, "Tx");
+
+    test_perf_record_save(&perf_record, iut_jobs_ctrl, "Fwd");
 
-    tapi_dpdk_stats_log_rates(TAPI_DPDK_L2FWD_NAME, &meas_stats_rx,
-                              packet_size, link_speed, "FwdRx");
+    TEST_STEP("Check whether the traffic generator is the bottleneck");
+    gen_bottleneck = test_generator_is_bottleneck(TAPI_DPDK_L2FWD_NAME,
+                                                  gen_capacity,
+                                                  meas_stats_tx.data.mean,
+                                                  link_speed, packet_size);
 
-    tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
-                              packet_size, link_speed, "Tx");
+    TEST_STEP("Compare the rate with performance baseline unless the "
+              "traffic generator is the bottleneck");
+    if (!gen_bottleneck &&
+        test_perf_below_baseline(TE_TEST_NAME, packet_size,
+                                 n_l2fwd_fwd_cores, meas_stats_tx.data.mean,
+                                 &deficit))
+        TEST_VERDICT("Throughput below baseline by %.0f%%", deficit);
 
     TEST_SUCCESS;
 
 cleanup:
+    test_perf_record_fini(&perf_record);
     tapi_dpdk_l2fwd_destroy(&l2fwd_job);
     tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
     te_kvpair_fini(traffic_generator_params);
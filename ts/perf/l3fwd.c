@@ -0,0 +1,550 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-l3fwd Test l3fwd application performance
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test l3fwd forwarding performance with LPM and exact match
+ *            lookups depending on the route table size
+ *
+ * @param generator_mode    Traffic generator mode, only @c flowgen
+ * @param testpmd_arg_txd   Traffic generator Tx ring size
+ * @param testpmd_arg_burst Traffic generator burst size
+ * @param testpmd_arg_txfreet Traffic generator Tx free threshold
+ * @param packet_size       Packet size without FCS as generated
+ * @param n_l3fwd_fwd_cores The number of l3fwd forwarding cores
+ * @param lookup            Lookup method:
+ *                          - @c lpm longest prefix match
+ *                          - @c em exact match
+ * @param route_table_size  The number of IPv4 routes
+ *
+ * @type performance
+ *
+ * The traffic generator runs in flowgen mode and sends @p route_table_size
+ * flows from 10.254.0.0 UDP port 1000 to 10.253.0.0 + N UDP port 1001.
+ * Exact match rules or /32 LPM routes are generated for these flows, so
+ * each flow is looked up in its own route and the table size affects
+ * lookups. All routes point to the port which packets are received on,
+ * so forwarded traffic returns to the traffic generator. l3fwd does not
+ * print statistics, so IUT rates are read from DPDK telemetry socket.
+ *
+ * l3fwd forwards packets which miss the routes to the port they are
+ * received on as well. So the hit rate is checked first by a separate
+ * l3fwd run in which routes point to a null port.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/l3fwd"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_file.h"
+#include "tapi_job.h"
+#include "tapi_job_factory_rpc.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+/** l3fwd application name */
+#define TEST_L3FWD_NAME "dpdk-l3fwd"
+/** Maximum number of LPM routes supported by l3fwd */
+#define TEST_L3FWD_LPM_MAX_RULES 1024U
+/** Timeout to wait for l3fwd to enter forwarding loop */
+#define TEST_L3FWD_START_TIMEOUT_MS 60000
+/** Interval of IUT statistics sampling from telemetry socket */
+#define TEST_L3FWD_STATS_INTERVAL_MS 1000
+
+/**
+ * Addresses and UDP ports of flows generated by testpmd in flowgen mode.
+ * The destination address is incremented for each next flow.
+ */
+#define TEST_L3FWD_FLOW_SRC_ADDR 0x0afe0000U /* 10.254.0.0 */
+#define TEST_L3FWD_FLOW_DST_ADDR 0x0afd0000U /* 10.253.0.0 */
+#define TEST_L3FWD_FLOW_SRC_PORT 1000U
+#define TEST_L3FWD_FLOW_DST_PORT 1001U
+
+/** Null port routes point to during hit rate check */
+#define TEST_L3FWD_NULL_VDEV "net_null0,no-rx=1"
+/** l3fwd port ID of the null port, it follows the IUT port */
+#define TEST_L3FWD_NULL_PORT 1U
+/** Minimum share of packets which must hit the routes, percents */
+#define TEST_L3FWD_MIN_HIT_RATE_PERCENT 99
+
+/** Format IPv4 address given in host byte order */
+#define TEST_IPV4_FMT "%u.%u.%u.%u"
+#define TEST_IPV4_ARGS(_addr) \
+    ((_addr) >> 24) & 0xff, ((_addr) >> 16) & 0xff, \
+    ((_addr) >> 8) & 0xff, (_addr) & 0xff
+
+/**
+ * Compose l3fwd IPv4 and IPv6 rule files contents.
+ *
+ * @param lpm           LPM rules if @c TRUE, exact match rules otherwise
+ * @param n_routes      The number of IPv4 routes
+ * @param out_port      Output port of all routes
+ * @param rules_v4      IPv4 rules
+ * @param rules_v6      IPv6 rules
+ */
+static void
+test_l3fwd_make_rules(te_bool lpm, unsigned int n_routes,
+                      unsigned int out_port, te_string *rules_v4,
+                      te_string *rules_v6)
+{
+    unsigned int i;
+
+    te_string_reset(rules_v4);
+    te_string_reset(rules_v6);
+
+    if (lpm)
+    {
+        for (i = 0; i < n_routes; i++)
+        {
+            uint32_t dst = TEST_L3FWD_FLOW_DST_ADDR + i;
+
+            te_string_append(rules_v4, "R" TEST_IPV4_FMT "/32 %u\n",
+                             TEST_IPV4_ARGS(dst), out_port);
+        }
+        te_string_append(rules_v6, "R2001:db8::/32 %u\n", out_port);
+    }
+    else
+    {
+        for (i = 0; i < n_routes; i++)
+        {
+            uint32_t dst = TEST_L3FWD_FLOW_DST_ADDR + i;
+
+            te_string_append(rules_v4,
+                             "R" TEST_IPV4_FMT " " TEST_IPV4_FMT
+                             " %u %u 0x11 %u\n",
+                             TEST_IPV4_ARGS(dst),
+                             TEST_IPV4_ARGS(TEST_L3FWD_FLOW_SRC_ADDR),
+                             TEST_L3FWD_FLOW_DST_PORT,
+                             TEST_L3FWD_FLOW_SRC_PORT, out_port);
+        }
+        te_string_append(rules_v6, "R2001:db8::2 2001:db8::1 %u %u 0x11 %u\n",
+                         TEST_L3FWD_FLOW_DST_PORT, TEST_L3FWD_FLOW_SRC_PORT,
+                         out_port);
+    }
+}
+
+/** Append argument to dynamically allocated NULL-terminated array */
+static void
+test_l3fwd_append_arg(int *argc, char ***argv, const char *fmt, ...)
+{
+    te_string arg = TE_STRING_INIT;
+    va_list ap;
+
+    va_start(ap, fmt);
+    CHECK_RC(te_string_append_va(&arg, fmt, ap));
+    va_end(ap);
+
+    *argv = tapi_realloc(*argv, (*argc + 2) * sizeof(**argv));
+    (*argv)[(*argc)++] = arg.ptr;
+    (*argv)[*argc] = NULL;
+}
+
+/**
+ * Create l3fwd IPv4 and IPv6 rule files on the agent.
+ *
+ * @param ta            Test agent name
+ * @param lpm           LPM rules if @c TRUE, exact match rules otherwise
+ * @param n_routes      The number of IPv4 routes
+ * @param out_port      Output port of all routes
+ * @param rules_v4_path IPv4 rule file path
+ * @param rules_v6_path IPv6 rule file path
+ */
+static void
+test_l3fwd_create_rule_files(const char *ta, te_bool lpm,
+                             unsigned int n_routes, unsigned int out_port,
+                             const char *rules_v4_path,
+                             const char *rules_v6_path)
+{
+    te_string rules_v4 = TE_STRING_INIT;
+    te_string rules_v6 = TE_STRING_INIT;
+
+    test_l3fwd_make_rules(lpm, n_routes, out_port, &rules_v4, &rules_v6);
+    CHECK_RC(tapi_file_create_ta(ta, rules_v4_path, "%s", rules_v4.ptr));
+    CHECK_RC(tapi_file_create_ta(ta, rules_v6_path, "%s", rules_v6.ptr));
+
+    te_string_free(&rules_v4);
+    te_string_free(&rules_v6);
+}
+
+/**
+ * Create and start l3fwd job and wait for it to enter forwarding loop.
+ *
+ * @param factory       Job factory
+ * @param rpcs          RPC server of the agent running l3fwd
+ * @param env           Environment
+ * @param path          l3fwd binary path
+ * @param n_cpus        The number of grabbed CPUs
+ * @param cpu_ids       Grabbed CPUs, the first one is used by main lcore
+ * @param lpm           Use LPM lookup if @c TRUE, exact match otherwise
+ * @param packet_size   Packet size without FCS
+ * @param tst_mac       Destination MAC address of forwarded packets
+ * @param rules_v4_path IPv4 rule file path
+ * @param rules_v6_path IPv6 rule file path
+ * @param null_port     Add a null port the routes may point to
+ * @param[out] job      l3fwd job
+ */
+static void
+test_l3fwd_start(tapi_job_factory_t *factory, rcf_rpc_server *rpcs,
+                 tapi_env *env, const char *path, size_t n_cpus,
+                 tapi_cpu_index_t *cpu_ids, te_bool lpm,
+                 unsigned int packet_size, const char *tst_mac,
+                 const char *rules_v4_path, const char *rules_v6_path,
+                 te_bool null_port, tapi_job_t **job)
+{
+    tapi_job_channel_t *out = NULL;
+    tapi_job_channel_t *started = NULL;
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_string config = TE_STRING_INIT;
+    char **argv = NULL;
+    int argc = 0;
+    unsigned int mtu;
+    size_t i;
+
+    CHECK_RC(tapi_dpdk_build_eal_arguments(rpcs, env, n_cpus, cpu_ids, path,
+                                           &argc, &argv));
+    if (null_port)
+    {
+        test_l3fwd_append_arg(&argc, &argv, "--vdev=%s",
+                              TEST_L3FWD_NULL_VDEV);
+    }
+
+    /* The first CPU is used by l3fwd main lcore which has no queues */
+    for (i = 1; i < n_cpus; i++)
+    {
+        te_string_append(&config, "%s(0,%u,%u)", i == 1 ? "" : ",",
+                         (unsigned int)(i - 1), cpu_ids[i].thread_id);
+    }
+    if (null_port)
+    {
+        te_string_append(&config, ",(%u,0,%u)", TEST_L3FWD_NULL_PORT,
+                         cpu_ids[1].thread_id);
+    }
+
+    test_l3fwd_append_arg(&argc, &argv, "--");
+    test_l3fwd_append_arg(&argc, &argv, "-p");
+    test_l3fwd_append_arg(&argc, &argv, "0x%x",
+                          null_port ? 1U | (1U << TEST_L3FWD_NULL_PORT) :
+                                      1U);
+    test_l3fwd_append_arg(&argc, &argv, "-P");
+    test_l3fwd_append_arg(&argc, &argv, "%s", lpm ? "-L" : "-E");
+    test_l3fwd_append_arg(&argc, &argv, "--parse-ptype");
+    /* l3fwd enables scattered Rx itself if packets do not fit in mbuf */
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        test_l3fwd_append_arg(&argc, &argv, "--max-pkt-len=%u",
+                              mtu + ETHER_HDR_LEN);
+    }
+    test_l3fwd_append_arg(&argc, &argv, "--config=%s", config.ptr);
+    test_l3fwd_append_arg(&argc, &argv, "--eth-dest=0,%s", tst_mac);
+    test_l3fwd_append_arg(&argc, &argv, "--rule_ipv4=%s", rules_v4_path);
+    test_l3fwd_append_arg(&argc, &argv, "--rule_ipv6=%s", rules_v6_path);
+
+    CHECK_RC(tapi_job_simple_create(factory,
+                &(tapi_job_simple_desc_t){
+                    .program = path,
+                    .argv = (const char **)argv,
+                    .job_loc = job,
+                    .stdout_loc = &out,
+                    .filters = TAPI_JOB_SIMPLE_FILTERS(
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = "entering main loop on lcore",
+                         .filter_var = &started,
+                         .log_level = TE_LL_RING,
+                         .filter_name = "l3fwd started"},
+                        {.use_stderr = TRUE, .log_level = TE_LL_WARN,
+                         .filter_name = "l3fwd stderr"}
+                    )
+                }));
+
+    for (i = 0; (int)i < argc; i++)
+        free(argv[i]);
+    free(argv);
+    te_string_free(&config);
+
+    CHECK_RC(tapi_job_start(*job));
+    if (tapi_job_receive(TAPI_JOB_CHANNEL_SET(started),
+                         TEST_L3FWD_START_TIMEOUT_MS, &buf) != 0)
+        TEST_VERDICT("l3fwd failed to start forwarding");
+
+    te_string_free(&buf.data);
+}
+
+/**
+ * Stop l3fwd job if it is running and destroy it.
+ *
+ * @param job           l3fwd job, set to @c NULL on return
+ */
+static void
+test_l3fwd_stop(tapi_job_t **job)
+{
+    if (*job == NULL)
+        return;
+
+    (void)tapi_job_kill(*job, SIGINT);
+    (void)tapi_job_wait(*job, TEST_TESTPMD_STOP_TIMEOUT_MS, NULL);
+    (void)tapi_job_destroy(*job, -1);
+    *job = NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+    tapi_job_factory_t *factory = NULL;
+    tapi_job_t *l3fwd_job = NULL;
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+    tapi_cpu_index_t *cpu_ids = NULL;
+    size_t n_cpus_grabbed = 0;
+
+    unsigned int link_speed;
+    const char *generator_mode;
+    unsigned int testpmd_arg_txd;
+    unsigned int testpmd_arg_burst;
+    unsigned int testpmd_arg_txfreet;
+    const char *lookup;
+    te_bool lpm;
+    unsigned int route_table_size;
+    unsigned int n_l3fwd_fwd_cores;
+    unsigned int n_peer_cores;
+    unsigned int packet_size;
+    const char *txpkts;
+    char *iut_mac = NULL;
+    char *tst_mac = NULL;
+    char *agent_dir = NULL;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    te_string l3fwd_path = TE_STRING_INIT;
+    te_string rules_v4_path = TE_STRING_INIT;
+    te_string rules_v6_path = TE_STRING_INIT;
+    te_bool rules_created = FALSE;
+
+    const unsigned int hit_check_ports[] = { 0, TEST_L3FWD_NULL_PORT };
+    te_meas_stats_t hit_check_tx[TE_ARRAY_LEN(hit_check_ports)] = {{0}};
+    te_meas_stats_t meas_stats_tx = {0};
+    te_meas_stats_t meas_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+
+    double hit_pps;
+    double miss_pps;
+    double hit_rate;
+    double gen_capacity;
+    te_bool gen_bottleneck;
+    double deficit;
+    unsigned int i;
+    te_mi_logger *logger = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(testpmd_arg_txd);
+    TEST_GET_UINT_PARAM(testpmd_arg_burst);
+    TEST_GET_UINT_PARAM(testpmd_arg_txfreet);
+    TEST_GET_UINT_PARAM(n_l3fwd_fwd_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_STRING_PARAM(lookup);
+    TEST_GET_UINT_PARAM(route_table_size);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    lpm = (strcmp(lookup, "lpm") == 0);
+    if (lpm && route_table_size > TEST_L3FWD_LPM_MAX_RULES)
+        TEST_SKIP("l3fwd supports up to %u LPM routes",
+                  TEST_L3FWD_LPM_MAX_RULES);
+    if (route_table_size < 2)
+        TEST_SKIP("At least two routes are required");
+    /* Routes are generated for flows of flowgen mode only */
+    if (strcmp(generator_mode, "flowgen") != 0)
+        TEST_FAIL("Generator mode '%s' is not supported", generator_mode);
+
+    TEST_STEP("Check that l3fwd is available on IUT");
+    CHECK_RC(cfg_get_string(&agent_dir, "/agent:%s/dir:", iut_jobs_ctrl->ta));
+    te_string_append(&l3fwd_path, "%s/%s", agent_dir, TEST_L3FWD_NAME);
+    if (test_run_agent_cmd(iut_jobs_ctrl, "test -x %s", l3fwd_path.ptr) != 0)
+        TEST_SKIP("l3fwd is not available on IUT");
+
+    te_string_append(&rules_v4_path, "%s/l3fwd_rules_v4.cfg", agent_dir);
+    te_string_append(&rules_v6_path, "%s/l3fwd_rules_v6.cfg", agent_dir);
+
+    TEST_STEP("Prepare traffic generator parameters to generate "
+              "@p route_table_size flows");
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    testpmd_arg_txd, testpmd_arg_burst,
+                                    testpmd_arg_txfreet,
+                                    &traffic_generator_params, &n_peer_cores));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "flowgen_flows",
+                           "%u", route_table_size));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    TEST_STEP("Measure traffic generator capacity running it on TST with "
+              "testpmd receiving traffic on IUT");
+    CHECK_RC(test_calibrate_generator(tst_jobs_ctrl, iut_jobs_ctrl, &env,
+                                      n_peer_cores, &prop,
+                                      traffic_generator_params, &test_params,
+                                      1, packet_size, &gen_capacity));
+
+    TEST_STEP("Grab CPUs for l3fwd");
+    cpu_ids = tapi_calloc(n_l3fwd_fwd_cores + 1, sizeof(*cpu_ids));
+    /* One more core is used by l3fwd main lcore which has no queues */
+    CHECK_RC(tapi_dpdk_grab_cpus_nonstrict_prop(iut_jobs_ctrl->ta,
+                                                n_l3fwd_fwd_cores + 1,
+                                                n_l3fwd_fwd_cores + 1, -1,
+                                                &prop, &n_cpus_grabbed,
+                                                cpu_ids));
+
+    CHECK_RC(cfg_get_string(&tst_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_TST_PORT, 0));
+    CHECK_RC(tapi_job_factory_rpc_create(iut_jobs_ctrl, &factory));
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_peer_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Create rule files with @p route_table_size routes pointing "
+              "to a null port on IUT and start l3fwd with @p lookup method "
+              "and the null port");
+    rules_created = TRUE;
+    test_l3fwd_create_rule_files(iut_jobs_ctrl->ta, lpm, route_table_size,
+                                 TEST_L3FWD_NULL_PORT, rules_v4_path.ptr,
+                                 rules_v6_path.ptr);
+    test_l3fwd_start(factory, iut_jobs_ctrl, &env, l3fwd_path.ptr,
+                     n_cpus_grabbed, cpu_ids, lpm, packet_size, tst_mac,
+                     rules_v4_path.ptr, rules_v6_path.ptr, TRUE, &l3fwd_job);
+
+    TEST_STEP("Start traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running testpmd");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job, &link_speed));
+
+    TEST_STEP("Check that generated traffic hits the routes: hits are sent "
+              "to the null port and misses to the IUT port");
+    for (i = 0; i < TE_ARRAY_LEN(hit_check_ports); i++)
+        CHECK_RC(test_meas_stats_init(&test_params, &hit_check_tx[i]));
+    CHECK_RC(test_telemetry_get_stats_ports(iut_jobs_ctrl, "l3fwd",
+                                            TEST_L3FWD_STATS_INTERVAL_MS,
+                                            TE_ARRAY_LEN(hit_check_ports),
+                                            hit_check_ports, hit_check_tx,
+                                            NULL));
+    miss_pps = hit_check_tx[0].data.mean;
+    hit_pps = hit_check_tx[1].data.mean;
+    if (hit_pps + miss_pps == 0)
+        TEST_VERDICT("Failure: l3fwd does not forward anything");
+    hit_rate = 100.0 * hit_pps / (hit_pps + miss_pps);
+    RING("%.1f%% of forwarded packets hit the routes", hit_rate);
+    if (hit_rate < TEST_L3FWD_MIN_HIT_RATE_PERCENT)
+        TEST_VERDICT("Only %.0f%% of packets hit the routes", hit_rate);
+
+    TEST_STEP("Restart l3fwd with the routes pointing to the IUT port");
+    test_l3fwd_stop(&l3fwd_job);
+    test_l3fwd_create_rule_files(iut_jobs_ctrl->ta, lpm, route_table_size,
+                                 0, rules_v4_path.ptr, rules_v6_path.ptr);
+    test_l3fwd_start(factory, iut_jobs_ctrl, &env, l3fwd_path.ptr,
+                     n_cpus_grabbed, cpu_ids, lpm, packet_size, tst_mac,
+                     rules_v4_path.ptr, rules_v6_path.ptr, FALSE, &l3fwd_job);
+
+    TEST_STEP("Initialize Tx and Rx statistics");
+    CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_tx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+    CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_rx));
+
+    TEST_STEP("Retrieve l3fwd stats from IUT telemetry socket");
+    CHECK_RC(test_telemetry_get_stats_many_ports(iut_jobs_ctrl, "l3fwd",
+                                                 TEST_L3FWD_STATS_INTERVAL_MS,
+                                                 1, &meas_stats_tx,
+                                                 &meas_stats_rx));
+
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         NULL));
+
+    if (meas_stats_tx.data.mean == 0 || meas_stats_rx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Rx or Tx packets per second");
+
+    CHECK_RC(te_mi_logger_meas_create(TEST_L3FWD_NAME, &logger));
+    te_mi_logger_add_comment(logger, NULL, "lookup", "%s", lookup);
+    te_mi_logger_add_comment(logger, NULL, "routes", "%u", route_table_size);
+    te_mi_logger_add_comment(logger, NULL, "hit_rate_percent", "%.1f",
+                             hit_rate);
+    te_mi_logger_destroy(logger);
+    logger = NULL;
+
+    test_stats_log_rates(TEST_L3FWD_NAME, &meas_stats_tx,
+                         packet_size, link_speed, "FwdTx");
+
+    test_stats_log_rates(TEST_L3FWD_NAME, &meas_stats_rx,
+                         packet_size, link_speed, "FwdRx");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         packet_size, link_speed, "Tx");
+
+    TEST_STEP("Check whether the traffic generator is the bottleneck");
+    gen_bottleneck = test_generator_is_bottleneck(TEST_L3FWD_NAME,
+                                                  gen_capacity,
+                                                  meas_stats_tx.data.mean,
+                                                  link_speed, packet_size);
+
+    TEST_STEP("Compare the rate with performance baseline unless the "
+              "traffic generator is the bottleneck");
+    if (!gen_bottleneck &&
+        test_perf_below_baseline(TE_TEST_NAME, packet_size,
+                                 n_l3fwd_fwd_cores, meas_stats_tx.data.mean,
+                                 &deficit))
+        TEST_VERDICT("Throughput below baseline by %.0f%%", deficit);
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_mi_logger_destroy(logger);
+    test_l3fwd_stop(&l3fwd_job);
+    tapi_job_factory_destroy(factory);
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+
+    for (i = 0; i < n_cpus_grabbed; i++)
+        CLEANUP_CHECK_RC(tapi_cfg_cpu_release_by_id(iut_jobs_ctrl->ta,
+                                                    &cpu_ids[i]));
+    free(cpu_ids);
+
+    if (rules_created)
+    {
+        (void)rcf_ta_del_file(iut_jobs_ctrl->ta, 0, rules_v4_path.ptr);
+        (void)rcf_ta_del_file(iut_jobs_ctrl->ta, 0, rules_v6_path.ptr);
+    }
+
+    for (i = 0; i < TE_ARRAY_LEN(hit_check_ports); i++)
+        te_meas_stats_free(&hit_check_tx[i]);
+    te_meas_stats_free(&meas_stats_tx);
+    te_meas_stats_free(&meas_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+    te_string_free(&l3fwd_path);
+    te_string_free(&rules_v4_path);
+    te_string_free(&rules_v6_path);
+    free(agent_dir);
+    free(iut_mac);
+    free(tst_mac);
+
+    TEST_END;
+}
+/** @} */
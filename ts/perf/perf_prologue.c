@@ -233,6 +233,11 @@ main(int argc, char **argv)
         CHECK_RC(test_add_pci_fn_prop(iut_jobs_ctrl, iut_port,
                                       "max_mtu", dev_info.max_mtu));
 
+        CHECK_RC(test_add_pci_fn_desc_lim(iut_jobs_ctrl, iut_port, TRUE,
+                                          &dev_info.rx_desc_lim));
+        CHECK_RC(test_add_pci_fn_desc_lim(iut_jobs_ctrl, iut_port, FALSE,
+                                          &dev_info.tx_desc_lim));
+
         for (i = 0; i < rpc_dpdk_tx_offloads_num; i++)
         {
             if (dev_info.tx_offload_capa & (1ULL << rpc_dpdk_tx_offloads[i].bit))
@@ -0,0 +1,302 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_burst_mode Test vector and scalar burst paths
+ * @ingroup perf
+ * @{
+ *
+ * @objective Compare dpdk-testpmd IO forwarding performance with
+ *            offloads which allow vector Rx/Tx burst functions and
+ *            with offloads which usually require scalar ones
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS as generated
+ * @param n_cores           The number of IUT testpmd cores
+ * @param testpmd_arg_rxq   The number of Rx and Tx queues
+ *
+ * @type performance
+ *
+ * The same workload is measured twice while the traffic generator
+ * is running:
+ * - @c Vector with no offloads enabled;
+ * - @c Scalar with Rx scatter and Tx multi-segment offloads enabled.
+ *
+ * Burst modes reported by the driver are logged for each run, and
+ * whether offloads change them is logged in BurstModesChanged MI comment.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_burst_mode"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** RTE_ETH_TX_OFFLOAD_MULTI_SEGS */
+#define TEST_TX_OFFLOAD_MULTI_SEGS 0x8000U
+
+/** Offload sets selecting burst path */
+enum test_burst_path {
+    TEST_BURST_PATH_VECTOR,
+    TEST_BURST_PATH_SCALAR,
+    TEST_BURST_N_PATHS,
+};
+
+/** Burst path names used in logs */
+static const char *test_burst_path_names[TEST_BURST_N_PATHS] = {
+    "Vector",
+    "Scalar",
+};
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int iut_link_speed = 0;
+    te_meas_stats_t iut_stats_rx = {0};
+    te_meas_stats_t iut_stats_tx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    const char *txpkts;
+    char *iut_mac = NULL;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    tapi_job_channel_t *burst_mode_filter = NULL;
+    te_string rx_modes[TEST_BURST_N_PATHS];
+    te_string tx_modes[TEST_BURST_N_PATHS];
+    te_bool modes_reported = TRUE;
+    double rates[TEST_BURST_N_PATHS] = {0};
+    double cycles[TEST_BURST_N_PATHS] = {0};
+    te_string title = TE_STRING_INIT;
+    te_mi_logger *logger = NULL;
+    unsigned int path;
+
+    for (path = 0; path < TEST_BURST_N_PATHS; path++)
+    {
+        rx_modes[path] = (te_string)TE_STRING_INIT;
+        tx_modes[path] = (te_string)TE_STRING_INIT;
+    }
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, TRUE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to use all forwarding cores");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "txq", "%s",
+                           TEST_STRING_PARAM(testpmd_arg_rxq)));
+
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+
+    TEST_STEP("Start traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Measure forwarding performance with each offload set");
+    for (path = 0; path < TEST_BURST_N_PATHS; path++)
+    {
+        if (path == TEST_BURST_PATH_SCALAR)
+        {
+            TEST_SUBSTEP("Enable Rx scatter and Tx multi-segment offloads "
+                         "to exclude vector burst functions");
+            /* The path is the last one, so parameters may be changed */
+            CHECK_RC(te_kvpair_add(&test_params,
+                                   TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                   "enable_scatter", "TRUE"));
+            CHECK_RC(te_kvpair_add(&test_params,
+                                   TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                   "tx_offloads", "%#x",
+                                   TEST_TX_OFFLOAD_MULTI_SEGS));
+        }
+
+        TEST_SUBSTEP("Create testpmd job and request Rx/Tx burst modes");
+        CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                              &prop, &test_params,
+                                              &iut_testpmd_job));
+        CHECK_RC(test_attach_burst_mode_filter(&iut_testpmd_job,
+                                               &burst_mode_filter));
+        if (cycles_supp)
+            CHECK_RC(test_attach_core_cycles_filter(&iut_testpmd_job,
+                                                    &cycles_filter));
+
+        TEST_SUBSTEP("Start testpmd and get burst modes reported by driver");
+        CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+        if (test_get_burst_mode(burst_mode_filter, &rx_modes[path]) != 0 ||
+            test_get_burst_mode(burst_mode_filter, &tx_modes[path]) != 0)
+        {
+            WARN("Burst modes are not reported by the driver");
+            modes_reported = FALSE;
+            te_string_reset(&rx_modes[path]);
+            te_string_reset(&tx_modes[path]);
+            te_string_append(&rx_modes[path], "unknown");
+            te_string_append(&tx_modes[path], "unknown");
+        }
+        RING("%s offloads: Rx burst mode '%s', Tx burst mode '%s'",
+             test_burst_path_names[path], rx_modes[path].ptr,
+             tx_modes[path].ptr);
+
+        TEST_SUBSTEP("Retrieve testpmd Rx and Tx stats");
+        CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&iut_testpmd_job,
+                                                  &iut_link_speed));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_tx));
+        CHECK_RC(tapi_dpdk_testpmd_get_stats(&iut_testpmd_job, &iut_stats_tx,
+                                             &iut_stats_rx));
+
+        if (iut_stats_rx.data.mean == 0 || iut_stats_tx.data.mean == 0)
+            TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+        te_string_reset(&title);
+        te_string_append(&title, "%sFwdTx", test_burst_path_names[path]);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_tx,
+                             packet_size, iut_link_speed,
+                             te_string_value(&title));
+        rates[path] = iut_stats_tx.data.mean;
+
+        TEST_SUBSTEP("Stop testpmd and get CPU cycles per packet");
+        if (cycles_supp)
+        {
+            CHECK_RC(test_stop_testpmd(&iut_testpmd_job));
+            CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter,
+                                                  &cycles[path]));
+            te_string_reset(&title);
+            te_string_append(&title, "%sCycles",
+                             test_burst_path_names[path]);
+            test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles[path],
+                                 te_string_value(&title));
+        }
+
+        tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+        memset(&iut_testpmd_job, 0, sizeof(iut_testpmd_job));
+        te_meas_stats_free(&iut_stats_rx);
+        te_meas_stats_free(&iut_stats_tx);
+    }
+
+    TEST_STEP("Log burst modes and the cost of offloads which require "
+              "scalar burst path");
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    for (path = 0; path < TEST_BURST_N_PATHS; path++)
+    {
+        te_string_reset(&title);
+        te_string_append(&title, "%sRxBurstMode",
+                         test_burst_path_names[path]);
+        te_mi_logger_add_comment(logger, NULL, te_string_value(&title),
+                                 "%s", rx_modes[path].ptr);
+        te_string_reset(&title);
+        te_string_append(&title, "%sTxBurstMode",
+                         test_burst_path_names[path]);
+        te_mi_logger_add_comment(logger, NULL, te_string_value(&title),
+                                 "%s", tx_modes[path].ptr);
+    }
+    te_mi_logger_add_comment(logger, NULL, "ScalarThroughputPenalty",
+                             "%.2f%%", 100 * (1 -
+                                 rates[TEST_BURST_PATH_SCALAR] /
+                                 rates[TEST_BURST_PATH_VECTOR]));
+    if (cycles_supp && cycles[TEST_BURST_PATH_VECTOR] > 0)
+    {
+        te_mi_logger_add_comment(logger, NULL, "ScalarCyclesPenalty",
+                                 "%.2f%%", 100 *
+                                     (cycles[TEST_BURST_PATH_SCALAR] /
+                                      cycles[TEST_BURST_PATH_VECTOR] - 1));
+    }
+
+    if (modes_reported)
+    {
+        te_bool same_modes =
+            strcmp(rx_modes[TEST_BURST_PATH_VECTOR].ptr,
+                   rx_modes[TEST_BURST_PATH_SCALAR].ptr) == 0 &&
+            strcmp(tx_modes[TEST_BURST_PATH_VECTOR].ptr,
+                   tx_modes[TEST_BURST_PATH_SCALAR].ptr) == 0;
+
+        if (same_modes)
+            RING("Offloads do not change Rx/Tx burst modes");
+        te_mi_logger_add_comment(logger, NULL, "BurstModesChanged", "%s",
+                                 same_modes ? "no" : "yes");
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_mi_logger_destroy(logger);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&iut_stats_rx);
+    te_meas_stats_free(&iut_stats_tx);
+    for (path = 0; path < TEST_BURST_N_PATHS; path++)
+    {
+        te_string_free(&rx_modes[path]);
+        te_string_free(&tx_modes[path]);
+    }
+    te_string_free(&title);
+    free(iut_mac);
+
+    TEST_END;
+}
+/** @} */
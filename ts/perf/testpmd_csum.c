@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_csum Test checksum offloads performance gain
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test dpdk-testpmd performance in checksum forward mode
+ *            with Rx/Tx checksum offloads enabled and disabled
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS as generated
+ * @param n_cores           The number of IUT testpmd cores
+ * @param encap             Encapsulation of generated packets:
+ *                          - @c none IPv4/UDP packets
+ *                          - @c vxlan_ipv4 IPv4/UDP in VXLAN over IPv4
+ *                          - @c vxlan_ipv6 IPv4/UDP in VXLAN over IPv6
+ * @param csum_offload      Offload checksums calculation and validation
+ *                          to the NIC if @c TRUE, do it in software
+ *                          otherwise
+ *
+ * @type performance
+ *
+ * Traffic is returned to the traffic generator on the same port. If
+ * packets are encapsulated, the traffic generator does it using egress
+ * flow rule, so TST NIC must support it.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_csum"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** Outer Ethernet, IPv4, UDP and VXLAN headers length */
+#define TEST_VXLAN_IPV4_OVERHEAD 50U
+/** Outer Ethernet, IPv6, UDP and VXLAN headers length */
+#define TEST_VXLAN_IPV6_OVERHEAD 70U
+
+/** Append testpmd commands to configure checksum calculation on IUT */
+static void
+test_append_csum_config(te_string *cmds, te_bool tunnel, te_bool hw)
+{
+    const char *engine = hw ? "hw" : "sw";
+
+    te_string_append(cmds, "port stop 0\n");
+    te_string_append(cmds, "csum set ip %s 0\n", engine);
+    te_string_append(cmds, "csum set udp %s 0\n", engine);
+    te_string_append(cmds, "csum set tcp %s 0\n", engine);
+    if (tunnel)
+    {
+        te_string_append(cmds, "csum parse-tunnel on 0\n");
+        te_string_append(cmds, "csum set outer-ip %s 0\n", engine);
+        te_string_append(cmds, "csum set outer-udp %s 0\n", engine);
+    }
+    te_string_append(cmds, "port start 0\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int tst_link_speed = 0;
+    te_meas_stats_t tst_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    const char *encap;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int wire_packet_size;
+    unsigned int overhead = 0;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    te_bool csum_offload;
+    const char *txpkts;
+    char *iut_mac = NULL;
+
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    double cycles;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_STRING_PARAM(encap);
+    TEST_GET_BOOL_PARAM(csum_offload);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    if (strcmp(encap, "vxlan_ipv4") == 0)
+        overhead = TEST_VXLAN_IPV4_OVERHEAD;
+    else if (strcmp(encap, "vxlan_ipv6") == 0)
+        overhead = TEST_VXLAN_IPV6_OVERHEAD;
+    wire_packet_size = packet_size + overhead;
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, wire_packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    if (tapi_dpdk_mtu_by_pkt_size(wire_packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+        CHECK_RC(te_kvpair_add(traffic_generator_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(wire_packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+        CHECK_RC(te_kvpair_add(traffic_generator_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to return traffic to the port "
+              "it is received on");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "port_topology",
+                           "loop"));
+
+    if (csum_offload)
+    {
+        TEST_STEP("If @p csum_offload is @c TRUE, enable Rx checksum "
+                  "offload");
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "enable_rx_cksum",
+                               "TRUE"));
+    }
+
+    TEST_STEP("Enable forwarding cores cycles recording if supported");
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+
+    TEST_STEP("Create testpmd job to forward traffic on IUT");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+
+    TEST_STEP("Calculate Tx checksums in hardware or software depending "
+              "on @p csum_offload");
+    test_append_csum_config(&iut_testpmd_job.cmdline_setup, overhead != 0,
+                            csum_offload);
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    if (overhead != 0)
+    {
+        TEST_STEP("If @p encap is not @c none, add egress flow rule to "
+                  "encapsulate generated packets in VXLAN on TST");
+        te_string_append(&tst_testpmd_job.cmdline_setup,
+                         "set vxlan ip-version %s vni 100 udp-src 4789 "
+                         "udp-dst 4789 ip-src %s ip-dst %s "
+                         "eth-src 00:00:5e:00:03:03 eth-dst %s\n",
+                         overhead == TEST_VXLAN_IPV4_OVERHEAD ?
+                            "ipv4" : "ipv6",
+                         overhead == TEST_VXLAN_IPV4_OVERHEAD ?
+                            "198.18.0.1" : "2001:db8::1",
+                         overhead == TEST_VXLAN_IPV4_OVERHEAD ?
+                            "198.18.0.2" : "2001:db8::2",
+                         iut_mac);
+        te_string_append(&tst_testpmd_job.cmdline_setup,
+                         "flow create 0 egress pattern eth / end "
+                         "actions vxlan_encap / end\n");
+    }
+
+    if (cycles_supp)
+        CHECK_RC(test_attach_core_cycles_filter(&iut_testpmd_job,
+                                                &cycles_filter));
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job,
+                                              &tst_link_speed));
+
+    TEST_STEP("Initialize TST Rx and Tx statistics");
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+
+    TEST_STEP("Retrieve Tx and returned Rx stats from traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         &tst_stats_rx));
+
+    TEST_STEP("Check and log measurement results");
+    if (tst_stats_rx.data.mean == 0 || tst_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         wire_packet_size, tst_link_speed, "Tx");
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx,
+                         wire_packet_size, tst_link_speed, "CsumRx");
+
+    if (cycles_supp)
+    {
+        TEST_STEP("Stop IUT testpmd and log CPU cycles per packet");
+        CHECK_RC(test_stop_testpmd(&iut_testpmd_job));
+        CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter, &cycles));
+        test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles, "CsumCycles");
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&tst_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+    free(iut_mac);
+
+    TEST_END;
+}
+/** @} */
@@ -0,0 +1,536 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_flow_aging Test flow rules aging at scale
+ * @ingroup perf
+ * @{
+ *
+ * @objective Install many flow rules with AGE action, keep a half of
+ *            them active with traffic and measure how accurately and
+ *            quickly the other half ages out
+ *
+ * @param generator_mode    Traffic generator mode, only @c flowgen
+ * @param packet_size       Packet size without FCS
+ * @param n_cores           The number of IUT testpmd forwarding cores
+ * @param n_rules           The number of flow rules, power of two
+ * @param age_timeout       Flow rule idle timeout, seconds
+ *
+ * @type performance
+ *
+ * Flow rule N matches destination IPv4 addresses with N in two least
+ * significant octets. The traffic generator sends @p n_rules / 2 flows
+ * to 10.253.0.0 + N, so only the first half of flow rules is hit while
+ * the second half stays idle from the moment it is created.
+ *
+ * testpmd on IUT is run interactively, so aged flow rules are retrieved
+ * periodically by "flow aged" command. Retrieved flow rules are destroyed
+ * to report each of them once. Flow rule IDs are not parsed, instead
+ * the total number of aged flow rules is checked to reach the number of
+ * idle flow rules and to stay the same while traffic keeps hitting
+ * the active flow rules.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_flow_aging"
+
+#include <sys/time.h>
+
+#include "dpdk_pmd_test.h"
+#include "tapi_file.h"
+#include "tapi_job.h"
+#include "tapi_job_factory_rpc.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "te_mi_log.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** testpmd application name */
+#define TEST_TESTPMD_NAME "dpdk-testpmd"
+
+/**
+ * Maximum number of flow rules, flows are split by two least significant
+ * octets of destination IPv4 address
+ */
+#define TEST_MAX_RULES 65536
+
+/** Timeout to wait for the result of flow rule validation */
+#define TEST_FLOW_VALIDATE_TIMEOUT_MS 60000
+
+/** Timeout to wait for creation of all flow rules */
+#define TEST_FLOW_CREATE_TIMEOUT_MS 300000
+
+/** Timeout to wait for the result of aged flow rules retrieval */
+#define TEST_FLOW_AGED_TIMEOUT_MS 60000
+
+/** Interval between aged flow rules retrievals */
+#define TEST_FLOW_AGED_POLL_MS 100
+
+/** Idle flow rules must age during this number of idle timeouts */
+#define TEST_AGED_WAIT_TIMEOUTS 3
+
+/**
+ * Active flow rules must not age during this number of idle timeouts
+ * after all idle flow rules are aged
+ */
+#define TEST_ACTIVE_TIMEOUTS 3
+
+/** Append argument to dynamically allocated NULL-terminated array */
+static void
+test_append_arg(int *argc, char ***argv, const char *fmt, ...)
+{
+    te_string arg = TE_STRING_INIT;
+    va_list ap;
+
+    va_start(ap, fmt);
+    CHECK_RC(te_string_append_va(&arg, fmt, ap));
+    va_end(ap);
+
+    *argv = tapi_realloc(*argv, (*argc + 2) * sizeof(**argv));
+    (*argv)[(*argc)++] = arg.ptr;
+    (*argv)[*argc] = NULL;
+}
+
+/**
+ * Create testpmd command file validating a flow rule with AGE action and
+ * creating flow rules with AGE action.
+ *
+ * @param ta            Test agent name
+ * @param path          Command file path
+ * @param n_rules       The number of flow rules
+ * @param age_timeout   Flow rule idle timeout, seconds
+ */
+static void
+test_create_aging_rules_file(const char *ta, const char *path,
+                             unsigned int n_rules, unsigned int age_timeout)
+{
+    te_string cmds = TE_STRING_INIT;
+    unsigned int mask = n_rules - 1;
+    unsigned int i;
+
+    te_string_append(&cmds,
+                     "flow validate 0 ingress pattern eth / ipv4 / end "
+                     "actions age timeout %u / queue index 0 / end\n",
+                     age_timeout);
+
+    for (i = 0; i < n_rules; i++)
+    {
+        te_string_append(&cmds,
+                         "flow create 0 ingress pattern eth / ipv4 "
+                         "dst spec 0.0.%u.%u dst mask 0.0.%u.%u / end "
+                         "actions age timeout %u / queue index 0 / end\n",
+                         i >> 8, i & 0xff, mask >> 8, mask & 0xff,
+                         age_timeout);
+    }
+
+    CHECK_RC(tapi_file_create_ta(ta, path, "%s", cmds.ptr));
+    te_string_free(&cmds);
+}
+
+/**
+ * Send a command to interactive testpmd.
+ *
+ * @param in            testpmd standard input
+ * @param cmd           Command without new line
+ */
+static void
+test_send_cmd(tapi_job_channel_t *in, const char *cmd)
+{
+    te_string str = TE_STRING_INIT;
+
+    te_string_append(&str, "%s\n", cmd);
+    CHECK_RC(tapi_job_send(in, &str));
+    te_string_free(&str);
+}
+
+/**
+ * Wait for a message extracted by a filter.
+ *
+ * @param filter        Filter
+ * @param timeout_ms    Timeout
+ * @param[out] msg      Location for the message or @c NULL
+ *
+ * @return @c TRUE if the message is received
+ */
+static te_bool
+test_wait_msg(tapi_job_channel_t *filter, int timeout_ms, te_string *msg)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_errno rc;
+
+    rc = tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter), timeout_ms, &buf);
+    if (rc != 0 && TE_RC_GET_ERROR(rc) != TE_ETIMEDOUT)
+        TEST_FAIL("Failed to receive testpmd output: %r", rc);
+
+    if (rc == 0 && msg != NULL)
+        te_string_append(msg, "%s", buf.data.ptr);
+
+    te_string_free(&buf.data);
+
+    return rc == 0;
+}
+
+/**
+ * Retrieve and destroy aged flow rules.
+ *
+ * @param in            testpmd standard input
+ * @param aged_filter   Filter extracting the number of aged flow rules
+ *
+ * @return The number of flow rules aged since the previous retrieval.
+ */
+static unsigned int
+test_get_aged_rules(tapi_job_channel_t *in, tapi_job_channel_t *aged_filter)
+{
+    te_string msg = TE_STRING_INIT;
+    int n_aged;
+
+    test_send_cmd(in, "flow aged 0 destroy");
+    if (!test_wait_msg(aged_filter, TEST_FLOW_AGED_TIMEOUT_MS, &msg))
+        TEST_FAIL("Aged flow rules are not reported");
+
+    CHECK_RC(te_strtoi(msg.ptr, 0, &n_aged));
+    if (n_aged < 0)
+        TEST_VERDICT("Failed to retrieve aged flow rules");
+
+    te_string_free(&msg);
+
+    return n_aged;
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_job_factory_t *factory = NULL;
+    tapi_job_t *iut_job = NULL;
+    tapi_job_channel_t *iut_in = NULL;
+    tapi_job_channel_t *validated_filter = NULL;
+    tapi_job_channel_t *error_filter = NULL;
+    tapi_job_channel_t *last_created_filter = NULL;
+    tapi_job_channel_t *aged_filter = NULL;
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+    te_string error_msg = TE_STRING_INIT;
+    te_string last_created_re = TE_STRING_INIT;
+    te_string testpmd_path = TE_STRING_INIT;
+    te_string rules_path = TE_STRING_INIT;
+    te_bool rules_created = FALSE;
+    char *agent_dir = NULL;
+    int iut_argc = 0;
+    char **iut_argv = NULL;
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+    tapi_cpu_index_t *cpu_ids = NULL;
+    size_t n_cpus_grabbed = 0;
+
+    unsigned int tst_link_speed = 0;
+    te_mi_logger *logger = NULL;
+
+    const char *generator_mode;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int n_rules;
+    unsigned int n_idle;
+    unsigned int n_aged = 0;
+    unsigned int age_timeout;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    const char *txpkts;
+    char *iut_mac;
+    unsigned int i;
+
+    struct timeval tv_validated;
+    struct timeval tv_created;
+    struct timeval tv_now;
+    long long insert_us;
+    long long now_us;
+    long long first_aged_us = -1;
+    long long last_aged_us = -1;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_UINT_PARAM(n_rules);
+    TEST_GET_UINT_PARAM(age_timeout);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    if (n_rules < 2 || n_rules > TEST_MAX_RULES ||
+        (n_rules & (n_rules - 1)) != 0)
+        TEST_VERDICT("The number of flow rules must be a power of two "
+                     "from 2 to %u", TEST_MAX_RULES);
+    /* Generated flows are matched by flow rules in flowgen mode only */
+    if (strcmp(generator_mode, "flowgen") != 0)
+        TEST_FAIL("Generator mode '%s' is not supported", generator_mode);
+    n_idle = n_rules / 2;
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    TEST_STEP("Check that testpmd is available on IUT");
+    CHECK_RC(cfg_get_string(&agent_dir, "/agent:%s/dir:", iut_jobs_ctrl->ta));
+    te_string_append(&testpmd_path, "%s/%s", agent_dir, TEST_TESTPMD_NAME);
+    te_string_append(&rules_path, "%s/flow_aging_rules.txt", agent_dir);
+
+    TEST_STEP("Prepare traffic generator parameters to hit the first half "
+              "of flow rules");
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "flowgen_flows",
+                           "%u", n_rules - n_idle));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+    free(iut_mac);
+
+    TEST_STEP("Create command file validating a flow rule with AGE action "
+              "and creating @p n_rules flow rules with AGE action, each "
+              "matching its own share of destination IPv4 addresses");
+    rules_created = TRUE;
+    test_create_aging_rules_file(iut_jobs_ctrl->ta, rules_path.ptr, n_rules,
+                                 age_timeout);
+
+    TEST_STEP("Create interactive testpmd job to receive traffic on IUT");
+    cpu_ids = tapi_calloc(n_cores + 1, sizeof(*cpu_ids));
+    /* One more core is used by testpmd main lcore which runs commands */
+    CHECK_RC(tapi_dpdk_grab_cpus_nonstrict_prop(iut_jobs_ctrl->ta,
+                                                n_cores + 1, n_cores + 1, -1,
+                                                &prop, &n_cpus_grabbed,
+                                                cpu_ids));
+    CHECK_RC(tapi_dpdk_build_eal_arguments(iut_jobs_ctrl, &env,
+                                           n_cpus_grabbed, cpu_ids,
+                                           testpmd_path.ptr, &iut_argc,
+                                           &iut_argv));
+    test_append_arg(&iut_argc, &iut_argv, "--");
+    test_append_arg(&iut_argc, &iut_argv, "-i");
+    test_append_arg(&iut_argc, &iut_argv, "--forward-mode=rxonly");
+    test_append_arg(&iut_argc, &iut_argv, "--no-lsc-interrupt");
+    test_append_arg(&iut_argc, &iut_argv, "--nb-cores=%u", n_cores);
+    test_append_arg(&iut_argc, &iut_argv, "--rxq=%u", n_cores);
+    test_append_arg(&iut_argc, &iut_argv, "--txq=%u", n_cores);
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        test_append_arg(&iut_argc, &iut_argv, "--max-pkt-len=%u",
+                        mtu + ETHER_HDR_LEN);
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        test_append_arg(&iut_argc, &iut_argv, "--mbuf-size=%u",
+                        mbuf_size);
+    }
+    test_append_arg(&iut_argc, &iut_argv, "--cmdline-file=%s",
+                    rules_path.ptr);
+
+    /* Flow rules are numbered from 0 on each port */
+    te_string_append(&last_created_re, "Flow rule #%u created",
+                     n_rules - 1);
+
+    CHECK_RC(tapi_job_factory_rpc_create(iut_jobs_ctrl, &factory));
+    CHECK_RC(tapi_job_simple_create(factory,
+                &(tapi_job_simple_desc_t){
+                    .program = testpmd_path.ptr,
+                    .argv = (const char **)iut_argv,
+                    .job_loc = &iut_job,
+                    .stdin_loc = &iut_in,
+                    .filters = TAPI_JOB_SIMPLE_FILTERS(
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = "Flow rule validated",
+                         .filter_var = &validated_filter,
+                         .log_level = TE_LL_RING,
+                         .filter_name = "Validated"},
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = "Caught PMD error[^\r\n]*",
+                         .filter_var = &error_filter,
+                         .log_level = TE_LL_WARN,
+                         .filter_name = "Flow error"},
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = last_created_re.ptr,
+                         .filter_var = &last_created_filter,
+                         .log_level = TE_LL_RING,
+                         .filter_name = "Last created"},
+                        {.use_stdout = TRUE, .readable = TRUE,
+                         .re = "Port 0 total aged flows: (-?[0-9]+)",
+                         .extract = 1,
+                         .filter_var = &aged_filter,
+                         .log_level = TE_LL_RING,
+                         .filter_name = "Aged"},
+                        {.use_stderr = TRUE, .log_level = TE_LL_WARN,
+                         .filter_name = "testpmd stderr"}
+                    )
+                }));
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Start traffic generator first to hit flow rules as soon as "
+              "they are created and wait for link up");
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job,
+                                              &tst_link_speed));
+
+    TEST_STEP("Start testpmd on IUT which runs the command file");
+    CHECK_RC(tapi_job_start(iut_job));
+
+    TEST_STEP("Skip the test if AGE action is not supported");
+    if (!test_wait_msg(validated_filter, TEST_FLOW_VALIDATE_TIMEOUT_MS,
+                       NULL))
+    {
+        if (test_wait_msg(error_filter, 0, &error_msg))
+            TEST_SKIP("AGE action is not supported: %s", error_msg.ptr);
+
+        TEST_FAIL("Flow rule validation result is not printed");
+    }
+    gettimeofday(&tv_validated, NULL);
+
+    TEST_STEP("Wait for all flow rules to be created and measure "
+              "insertion time");
+    if (!test_wait_msg(last_created_filter, TEST_FLOW_CREATE_TIMEOUT_MS,
+                       NULL))
+    {
+        if (test_wait_msg(error_filter, 0, &error_msg))
+            TEST_VERDICT("Failed to create all flow rules: %s",
+                         error_msg.ptr);
+
+        TEST_FAIL("Flow rules creation is not finished in time");
+    }
+    gettimeofday(&tv_created, NULL);
+    insert_us = TIMEVAL_SUB(tv_created, tv_validated);
+
+    TEST_STEP("Start receiving traffic on IUT");
+    test_send_cmd(iut_in, "start");
+
+    TEST_STEP("Retrieve aged flow rules periodically until all idle flow "
+              "rules are aged and then during a few more idle timeouts "
+              "with traffic hitting active flow rules. Check that only "
+              "idle flow rules are aged.");
+    do {
+        usleep(TEST_FLOW_AGED_POLL_MS * 1000);
+
+        i = test_get_aged_rules(iut_in, aged_filter);
+        gettimeofday(&tv_now, NULL);
+        /*
+         * Idle flow rules are never hit, so they age since creation.
+         * Flow rules aged during insertion are counted at the first
+         * retrieval.
+         */
+        now_us = TIMEVAL_SUB(tv_now, tv_validated);
+
+        if (i > 0)
+        {
+            if (first_aged_us < 0)
+                first_aged_us = now_us;
+            if (n_aged < n_idle)
+                last_aged_us = now_us;
+            n_aged += i;
+        }
+
+        if (n_aged > n_idle)
+            TEST_VERDICT("Flow rules are aged while traffic hits them");
+
+        if (n_aged < n_idle &&
+            now_us > (long long)age_timeout * TEST_AGED_WAIT_TIMEOUTS *
+                     1000000 + insert_us)
+        {
+            TEST_VERDICT("%u%% of idle flow rules are not reported aged",
+                         (n_idle - n_aged) * 100 / n_idle);
+        }
+    } while (n_aged < n_idle ||
+             now_us - last_aged_us <
+             (long long)age_timeout * TEST_ACTIVE_TIMEOUTS * 1000000);
+
+    TEST_STEP("Log the results");
+    RING("%u flow rules inserted in %lld us, %u idle flow rules reported "
+         "aged from %lld us to %lld us after insertion start with idle "
+         "timeout %u s", n_rules, insert_us, n_idle, first_aged_us,
+         last_aged_us, age_timeout);
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "rules", "%u", n_rules);
+    te_mi_logger_add_meas_key(logger, NULL, "idle_rules", "%u", n_idle);
+    te_mi_logger_add_meas_key(logger, NULL, "age_timeout", "%u",
+                              age_timeout);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_RPS, "insertion_rate",
+                          TE_MI_MEAS_AGGR_SINGLE,
+                          insert_us > 0 ?
+                            (double)n_rules * 1000000 / insert_us : 0,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, "first_aged",
+                          TE_MI_MEAS_AGGR_SINGLE, first_aged_us,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, "last_aged",
+                          TE_MI_MEAS_AGGR_SINGLE, last_aged_us,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, "aging_spread",
+                          TE_MI_MEAS_AGGR_SINGLE,
+                          last_aged_us - first_aged_us,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY,
+                          "aging_overshoot", TE_MI_MEAS_AGGR_SINGLE,
+                          last_aged_us - insert_us -
+                          (long long)age_timeout * 1000000,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_destroy(logger);
+
+    if (first_aged_us < (long long)age_timeout * 1000000)
+        TEST_VERDICT("Flow rules are aged before idle timeout expires");
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (iut_job != NULL)
+    {
+        (void)tapi_job_kill(iut_job, SIGINT);
+        (void)tapi_job_wait(iut_job, TEST_TESTPMD_STOP_TIMEOUT_MS, NULL);
+        (void)tapi_job_destroy(iut_job, -1);
+    }
+    tapi_job_factory_destroy(factory);
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+
+    for (i = 0; i < n_cpus_grabbed; i++)
+        CLEANUP_CHECK_RC(tapi_cfg_cpu_release_by_id(iut_jobs_ctrl->ta,
+                                                    &cpu_ids[i]));
+    free(cpu_ids);
+    for (i = 0; (int)i < iut_argc; i++)
+        free(iut_argv[i]);
+    free(iut_argv);
+
+    if (rules_created)
+        (void)rcf_ta_del_file(iut_jobs_ctrl->ta, 0, rules_path.ptr);
+
+    te_string_free(&error_msg);
+    te_string_free(&last_created_re);
+    te_string_free(&testpmd_path);
+    te_string_free(&rules_path);
+    free(agent_dir);
+
+    TEST_END;
+}
+/** @} */
@@ -10,9 +10,18 @@
  *
  * @objective Test dpdk-testpmd performance in IO forward mode
  *
+ * @param mbuf_fast_free    Enable MBUF_FAST_FREE Tx offload if @c TRUE
+ *                          (optional, disabled by default)
+ * @param generator_burst   Traffic generator burst size; big bursts make
+ *                          load bursty (optional)
  *
  * @type performance
  *
+ * If there are several ports, they are paired and traffic generator
+ * sends on all ports, so every pair of IUT ports forwards traffic in
+ * both directions simultaneously. Rate of each direction and aggregate
+ * full-duplex rate are reported in this case.
+ *
  * @author Andrew Rybchenko <andrew.rybchenko@oktetlabs.ru>
  *
  *
@@ -32,6 +41,64 @@
 #define TEST_TESTPMD_TX_GENERATOR_BURST 128U
 #define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
 
+/**
+ * Log rate of each forwarding direction of paired ports and aggregate
+ * full-duplex rates.
+ *
+ * @param n_ports       The number of ports
+ * @param iut_rx        IUT Rx statistics per port
+ * @param iut_tx        IUT Tx statistics per port
+ * @param tst_rx        TST Rx statistics per port
+ * @param packet_size   Packet size
+ * @param link_speed    IUT link speed per port
+ */
+static void
+test_log_bidir_rates(unsigned int n_ports, te_meas_stats_t *iut_rx,
+                     te_meas_stats_t *iut_tx, te_meas_stats_t *tst_rx,
+                     unsigned int packet_size, unsigned int *link_speed)
+{
+    te_string title = TE_STRING_INIT;
+    te_mi_logger *logger;
+    double aggr_pps = 0;
+    unsigned int port;
+    unsigned int peer;
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+
+    for (port = 0; port < n_ports; port++)
+    {
+        /* testpmd pairs ports 0 and 1, 2 and 3 and so on */
+        peer = port ^ 1;
+        if (peer >= n_ports)
+            continue;
+
+        te_string_reset(&title);
+        te_string_append(&title, "Dir%uto%u", port, peer);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_rx[peer],
+                             packet_size, link_speed[peer],
+                             te_string_value(&title));
+
+        te_string_reset(&title);
+        te_string_append(&title, "Duplex%u", port);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS,
+                              te_string_value(&title),
+                              TE_MI_MEAS_AGGR_MEAN,
+                              iut_rx[port].data.mean +
+                              iut_tx[port].data.mean,
+                              TE_MI_MEAS_MULTIPLIER_PLAIN);
+
+        aggr_pps += tst_rx[peer].data.mean;
+    }
+
+    RING("Aggregate bidirectional forwarding rate is %.3f Mpps",
+         aggr_pps / 1e6);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "BidirAggr",
+                          TE_MI_MEAS_AGGR_MEAN, aggr_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_destroy(logger);
+    te_string_free(&title);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -66,14 +133,37 @@ main(int argc, char *argv[])
     unsigned int mtu;
     unsigned int packet_size;
     const char *txpkts;
+    te_bool mbuf_fast_free = FALSE;
+    unsigned int generator_burst = TEST_TESTPMD_TX_GENERATOR_BURST;
     size_t idx;
 
     te_kvpair_h *traffic_generator_params = NULL;
 
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    double cycles;
+
+    te_bool bursts_supp;
+    tapi_job_channel_t *rx_bursts_filter = NULL;
+    tapi_job_channel_t *tx_bursts_filter = NULL;
+    tapi_job_channel_t *nombuf_filter = NULL;
+    tapi_job_channel_t *missed_filter = NULL;
+
+    test_perf_stat perf_stat;
+    test_perf_record perf_record;
+    double fwd_pps = 0;
+    double gen_capacity;
+    unsigned int total_link_speed = 0;
+    te_bool gen_bottleneck;
+    double deficit;
+
     te_bool dbells_supp;
     te_kvpair_h dbells_opt;
     te_kvpair_init(&dbells_opt);
 
+    test_perf_stat_init(&perf_stat);
+    test_perf_record_init(&perf_record);
+
     TEST_START;
     TEST_GET_PCO(iut_jobs_ctrl);
     TEST_GET_PCO(tst_jobs_ctrl);
@@ -82,6 +172,10 @@ main(int argc, char *argv[])
     TEST_GET_UINT_PARAM(n_cores);
     TEST_GET_UINT_PARAM(packet_size);
     txpkts = TEST_STRING_PARAM(packet_size);
+    if (TEST_HAS_PARAM(mbuf_fast_free))
+        TEST_GET_BOOL_PARAM(mbuf_fast_free);
+    if (TEST_HAS_PARAM(generator_burst))
+        TEST_GET_UINT_PARAM(generator_burst);
 
     for (idx = 0; idx < TE_ARRAY_LEN(iut_ifs); ++idx, ++n_ports)
     {
@@ -100,6 +194,32 @@ main(int argc, char *argv[])
             TEST_SKIP("So many Rx queues are not supported");
         }
 
+        if (mbuf_fast_free &&
+            !test_conf_tx_offload_supported(iut_jobs_ctrl, iut_ifs[idx],
+                    TARPC_RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE_BIT))
+            TEST_SKIP("MBUF_FAST_FREE is not supported");
+
+        if (TEST_HAS_PARAM(testpmd_arg_rxd))
+        {
+            struct tarpc_rte_eth_desc_lim desc_lim;
+
+            CHECK_RC(test_get_pci_fn_desc_lim(iut_jobs_ctrl, iut_ifs[idx],
+                                              TRUE, &desc_lim));
+            if (test_desc_nb_violates_limits(
+                    TEST_UINT_PARAM(testpmd_arg_rxd), &desc_lim))
+                TEST_SKIP("Rx descriptors number violates limits");
+        }
+        if (TEST_HAS_PARAM(testpmd_arg_txd))
+        {
+            struct tarpc_rte_eth_desc_lim desc_lim;
+
+            CHECK_RC(test_get_pci_fn_desc_lim(iut_jobs_ctrl, iut_ifs[idx],
+                                              FALSE, &desc_lim));
+            if (test_desc_nb_violates_limits(
+                    TEST_UINT_PARAM(testpmd_arg_txd), &desc_lim))
+                TEST_SKIP("Tx descriptors number violates limits");
+        }
+
         test_check_mtu(iut_jobs_ctrl, iut_ifs[idx], packet_size);
     }
 
@@ -109,7 +229,7 @@ main(int argc, char *argv[])
                                     generator_mode, txpkts,
                                     testpmd_arg_rxq > 1, 0,
                                     TEST_TESTPMD_TX_GENERATOR_TXD,
-                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    generator_burst,
                                     TEST_TESTPMD_TX_GENERATOR_TXFREET,
                                     &traffic_generator_params,
                                     &n_tst_cores));
@@ -156,6 +276,17 @@ main(int argc, char *argv[])
     CHECK_RC(te_kvpair_add(&test_params, "testpmd_arg_txq", "%s",
                            TEST_STRING_PARAM(testpmd_arg_rxq)));
 
+    if (mbuf_fast_free)
+    {
+        /*
+         * Enable MBUF_FAST_FREE Tx offload.
+         * TODO avoid hardcodes: RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE is
+         * RTE_BIT64(16)
+         */
+        CHECK_RC(te_kvpair_add(&test_params, "testpmd_arg_tx_offloads",
+                               "0x%llx", 1ULL << 16));
+    }
+
     CHECK_RC(tapi_dpdk_add_rx_dbells_display(&dbells_opt,
                                         TEST_STRING_PARAM(testpmd_arg_rxq)));
 
@@ -169,6 +300,18 @@ main(int argc, char *argv[])
                                         TEST_STRING_PARAM(testpmd_arg_rxq)));
     }
 
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+    CHECK_RC(test_add_record_burst_stats(iut_jobs_ctrl, &env, &test_params,
+                                         &bursts_supp));
+
+    TEST_STEP("Measure traffic generator capacity running it on TST with "
+              "testpmd receiving traffic on IUT");
+    CHECK_RC(test_calibrate_generator(tst_jobs_ctrl, iut_jobs_ctrl, &env,
+                                      n_tst_cores, &prop,
+                                      traffic_generator_params, &test_params,
+                                      n_ports, packet_size, &gen_capacity));
+
     TEST_STEP("Create testpmd job to run rxonly on IUT");
     CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
                                           &prop, &test_params,
@@ -188,6 +331,32 @@ main(int argc, char *argv[])
         CHECK_RC(tapi_dpdk_attach_dbells_filter_tx(&iut_testpmd_job));
     }
 
+    if (cycles_supp)
+    {
+        TEST_STEP("Attach CPU cycles filter");
+        CHECK_RC(test_attach_core_cycles_filter(&iut_testpmd_job,
+                                                &cycles_filter));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Attach burst stats filters");
+        CHECK_RC(test_attach_burst_stats_filter(&iut_testpmd_job, TRUE,
+                                                &rx_bursts_filter));
+        CHECK_RC(test_attach_burst_stats_filter(&iut_testpmd_job, FALSE,
+                                                &tx_bursts_filter));
+    }
+
+    TEST_STEP("Attach Rx mbuf allocation failures and missed packets "
+              "filters");
+    CHECK_RC(test_attach_port_counter_filter(&iut_testpmd_job, "RX-nombuf",
+                                             &nombuf_filter));
+    CHECK_RC(test_attach_port_counter_filter(&iut_testpmd_job, "RX-missed",
+                                             &missed_filter));
+
+    CHECK_RC(test_perf_stat_attach(&perf_stat, iut_testpmd_job.out_chs[0]));
+    CHECK_RC(test_perf_record_attach(&perf_record, iut_testpmd_job.out_chs[0]));
+
     CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
     CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
 
@@ -203,21 +372,25 @@ main(int argc, char *argv[])
                                                          tst_ports,
                                                          tst_link_speed));
 
+    TEST_STEP("Start hardware performance counters collection and "
+              "profiling on IUT forwarding cores if requested");
+    test_perf_stat_start(&perf_stat, iut_jobs_ctrl);
+    test_perf_record_start(&perf_record, iut_jobs_ctrl);
+
     TEST_STEP("Initialize IUT Rx and TST Tx statistics");
     for (port = 0; port < n_ports; ++port)
     {
-        CHECK_RC(test_meas_stats_init(&iut_stats_rx[port]));
-        CHECK_RC(test_meas_stats_init(&iut_stats_tx[port]));
-        CHECK_RC(test_meas_stats_init(&tst_stats_rx[port]));
-        CHECK_RC(test_meas_stats_init(&tst_stats_tx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_tx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx[port]));
     }
 
     TEST_STEP("Retrieve Rx stats from running testpmd");
-    CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&iut_testpmd_job,
-                                                    n_ports,
-                                                    &n_iut_ports, iut_ports,
-                                                    iut_stats_tx,
-                                                    iut_stats_rx));
+    CHECK_RC(test_testpmd_get_stats_many_ports(iut_jobs_ctrl, &test_params,
+                                               &iut_testpmd_job, n_ports,
+                                               &n_iut_ports, iut_ports,
+                                               iut_stats_tx, iut_stats_rx));
 
     TEST_STEP("Retrieve Tx stats from running testpmd");
     CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&tst_testpmd_job,
@@ -235,37 +408,40 @@ main(int argc, char *argv[])
             tst_stats_tx[port].data.mean == 0)
             TEST_VERDICT("Failure: zero Tx or Rx packets per second");
 
+        fwd_pps += iut_stats_rx[port].data.mean;
+        total_link_speed += tst_link_speed[port];
+
         te_string_reset(&str);
         te_string_append(&str, "FwdRx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[port],
-                                  packet_size, iut_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[port],
+                             packet_size, iut_link_speed[port],
+                             te_string_value(&str));
 
         te_string_reset(&str);
         te_string_append(&str, "FwdTx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_tx[port],
-                                  packet_size, iut_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_tx[port],
+                             packet_size, iut_link_speed[port],
+                             te_string_value(&str));
 
         te_string_reset(&str);
         te_string_append(&str, "Rx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx[port],
-                                  packet_size, tst_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx[port],
+                             packet_size, tst_link_speed[port],
+                             te_string_value(&str));
 
         te_string_reset(&str);
         te_string_append(&str, "Tx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx[port],
-                                  packet_size, tst_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx[port],
+                             packet_size, tst_link_speed[port],
+                             te_string_value(&str));
 
         if (dbells_supp)
         {
@@ -284,11 +460,61 @@ main(int argc, char *argv[])
         tapi_dpdk_stats_log_aggr_rates(TAPI_DPDK_TESTPMD_NAME, n_ports,
                                        iut_stats_tx, packet_size,
                                        iut_link_speed, "FwdTx");
+
+        TEST_STEP("If there are several ports, log rates of each "
+                  "forwarding direction and aggregate full-duplex rates");
+        test_log_bidir_rates(n_ports, iut_stats_rx, iut_stats_tx,
+                             tst_stats_rx, packet_size, iut_link_speed);
+    }
+
+    test_log_port_counter(TAPI_DPDK_TESTPMD_NAME, nombuf_filter, n_ports,
+                          "FwdRxNombuf");
+    test_log_port_counter(TAPI_DPDK_TESTPMD_NAME, missed_filter, n_ports,
+                          "FwdRxMissed");
+
+    test_perf_stat_log(&perf_stat, TAPI_DPDK_TESTPMD_NAME, fwd_pps, "Fwd");
+    test_perf_record_save(&perf_record, iut_jobs_ctrl, "Fwd");
+
+    if (cycles_supp || bursts_supp)
+    {
+        TEST_STEP("Stop IUT testpmd to get its forwarding statistics");
+        CHECK_RC(test_stop_testpmd(&iut_testpmd_job));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Log burst sizes distribution");
+        CHECK_RC(test_log_burst_stats(TAPI_DPDK_TESTPMD_NAME,
+                                      rx_bursts_filter, "RxBursts"));
+        CHECK_RC(test_log_burst_stats(TAPI_DPDK_TESTPMD_NAME,
+                                      tx_bursts_filter, "TxBursts"));
     }
 
+    if (cycles_supp)
+    {
+        TEST_STEP("Log CPU cycles per packet");
+        CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter, &cycles));
+        test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles, "FwdCycles");
+    }
+
+    TEST_STEP("Check whether the traffic generator is the bottleneck");
+    gen_bottleneck = test_generator_is_bottleneck(TAPI_DPDK_TESTPMD_NAME,
+                                                  gen_capacity, fwd_pps,
+                                                  total_link_speed,
+                                                  packet_size);
+
+    TEST_STEP("Compare the rate with performance baseline unless the "
+              "traffic generator is the bottleneck");
+    if (!gen_bottleneck &&
+        test_perf_below_baseline(TE_TEST_NAME, packet_size, n_cores, fwd_pps,
+                                 &deficit))
+        TEST_VERDICT("Throughput below baseline by %.0f%%", deficit);
+
     TEST_SUCCESS;
 
 cleanup:
+    test_perf_stat_fini(&perf_stat);
+    test_perf_record_fini(&perf_record);
     tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
     tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
     te_kvpair_fini(traffic_generator_params);
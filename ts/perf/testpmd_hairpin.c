@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_hairpin Test hairpin queues forwarding performance
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test forwarding performance of hairpin queues which bounce
+ *            traffic inside the NIC and compare it with dpdk-testpmd
+ *            IO forwarding
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS
+ * @param testpmd_arg_rxq   The number of regular Rx/Tx queues
+ * @param n_cores           The number of IUT testpmd cores
+ * @param hairpin           Steer all received traffic into a hairpin
+ *                          queue using a flow rule if @c TRUE, forward it
+ *                          by testpmd in IO mode otherwise
+ *
+ * @type performance
+ *
+ * The hairpin queue is bound to the same port, so in both cases the
+ * traffic is returned to the traffic generator and its Rx rate is the
+ * forwarding rate. Forwarding cores are idle in the hairpin case.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_hairpin"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** The number of hairpin queues to set up */
+#define TEST_N_HAIRPIN_QUEUES 1
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int tst_link_speed = 0;
+    te_meas_stats_t tst_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    unsigned int testpmd_arg_rxq;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    te_bool hairpin;
+    const char *txpkts;
+    char *iut_mac;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(testpmd_arg_rxq);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_BOOL_PARAM(hairpin);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+    free(iut_mac);
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to return traffic to the port "
+              "it is received on");
+    CHECK_RC(te_kvpair_add(&test_params, "testpmd_arg_txq", "%s",
+                           TEST_STRING_PARAM(testpmd_arg_rxq)));
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "port_topology",
+                           "loop"));
+    if (hairpin)
+    {
+        TEST_SUBSTEP("If @p hairpin is @c TRUE, set up hairpin queues "
+                     "bound to the same port");
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "hairpinq",
+                               "%u", TEST_N_HAIRPIN_QUEUES));
+    }
+
+    TEST_STEP("Create testpmd job to forward traffic on IUT");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+
+    if (hairpin)
+    {
+        TEST_STEP("If @p hairpin is @c TRUE, add flow rule to steer all "
+                  "received traffic into the first hairpin queue");
+        /* Hairpin queues are numbered after regular ones */
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 ingress pattern eth / end "
+                         "actions queue index %u / end\n", testpmd_arg_rxq);
+    }
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job,
+                                              &tst_link_speed));
+
+    TEST_STEP("Initialize TST Rx and Tx statistics");
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+
+    TEST_STEP("Retrieve Tx and returned Rx stats from traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         &tst_stats_rx));
+
+    TEST_STEP("Check and log measurement results");
+    if (tst_stats_rx.data.mean == 0 || tst_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         packet_size, tst_link_speed, "Tx");
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx,
+                         packet_size, tst_link_speed,
+                         hairpin ? "HairpinRx" : "FwdRx");
+
+    TEST_SUCCESS;
+
+cleanup:
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&tst_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+
+    TEST_END;
+}
+/** @} */
@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_hugepages Test hugepage size and IOVA mode impact
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test dpdk-testpmd IO forwarding performance depending on
+ *            huge page size and IOVA mode
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS as generated
+ * @param n_cores           The number of IUT testpmd cores
+ * @param testpmd_arg_rxq   The number of Rx and Tx queues
+ * @param hugepage_size     Huge page size, kilobytes
+ * @param iova_mode         IOVA mode:
+ *                          - @c pa physical addresses
+ *                          - @c va virtual addresses
+ *
+ * @type performance
+ *
+ * IOMMU state of the IUT host is fixed by the host configuration
+ * (see vfio module preparation in the test suite prologue), so it is
+ * logged together with the results to compare runs on different hosts.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_hugepages"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_file.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** Extra EAL arguments used by TAPI to run DPDK applications on an agent */
+#define TEST_EXTRA_EAL_ARGS_OID_FMT "/local:%s/dpdk:/extra_eal_args:"
+
+/** Mount point of hugetlbfs with the huge page size under test */
+#define TEST_HUGE_DIR_FMT "/tmp/te_hugetlbfs_%ukB"
+
+/** Get the number of free huge pages of the given size on the agent */
+static unsigned int
+test_get_free_hugepages(const char *ta, unsigned int hugepage_size)
+{
+    te_string path = TE_STRING_INIT;
+    unsigned int nb_free = 0;
+    char *value = NULL;
+
+    te_string_append(&path, "/sys/kernel/mm/hugepages/hugepages-%ukB/"
+                     "free_hugepages", hugepage_size);
+    if (tapi_file_read_ta(ta, path.ptr, &value) == 0)
+        nb_free = strtoul(value, NULL, 10);
+
+    free(value);
+    te_string_free(&path);
+
+    return nb_free;
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int iut_link_speed = 0;
+    te_meas_stats_t iut_stats_rx = {0};
+    te_meas_stats_t iut_stats_tx = {0};
+    unsigned int n_ports_found;
+    unsigned int port;
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    const char *iova_mode;
+    unsigned int hugepage_size;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    const char *txpkts;
+    char *iut_mac = NULL;
+    char *iommu = NULL;
+    char *extra_eal_args = NULL;
+    te_string huge_dir = TE_STRING_INIT;
+    te_string eal_args = TE_STRING_INIT;
+    te_bool mounted = FALSE;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+    te_mi_logger *logger = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_UINT_PARAM(hugepage_size);
+    TEST_GET_STRING_PARAM(iova_mode);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    TEST_STEP("Check IOMMU state and huge pages availability on IUT");
+    CHECK_RC(cfg_get_string(&iommu, "/agent:%s/hardware:/iommu:",
+                            iut_jobs_ctrl->ta));
+    if (strcmp(iova_mode, "va") == 0 && strcmp(iommu, "off") == 0)
+        TEST_SKIP("IOVA as VA requires IOMMU enabled on IUT");
+
+    if (test_get_free_hugepages(iut_jobs_ctrl->ta, hugepage_size) == 0)
+        TEST_SKIP("No free %ukB huge pages on IUT", hugepage_size);
+
+    TEST_STEP("Mount hugetlbfs with @p hugepage_size pages on IUT");
+    te_string_append(&huge_dir, TEST_HUGE_DIR_FMT, hugepage_size);
+    CHECK_RC(test_run_agent_cmd(iut_jobs_ctrl, "mkdir -p %s && "
+                                "mount -t hugetlbfs -o pagesize=%uK "
+                                "nodev %s", huge_dir.ptr, hugepage_size,
+                                huge_dir.ptr));
+    mounted = TRUE;
+
+    TEST_STEP("Make IUT DPDK applications use the mount point and "
+              "@p iova_mode");
+    if (cfg_get_string(&extra_eal_args, TEST_EXTRA_EAL_ARGS_OID_FMT,
+                       iut_jobs_ctrl->ta) != 0)
+        TEST_SKIP("Extra EAL arguments are not supported on IUT");
+
+    te_string_append(&eal_args, "%s --huge-dir %s --iova-mode %s",
+                     extra_eal_args, huge_dir.ptr, iova_mode);
+    CHECK_RC(cfg_set_instance_fmt(CFG_VAL(STRING, eal_args.ptr),
+                                  TEST_EXTRA_EAL_ARGS_OID_FMT,
+                                  iut_jobs_ctrl->ta));
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, TRUE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to use all forwarding cores");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "txq", "%s",
+                           TEST_STRING_PARAM(testpmd_arg_rxq)));
+
+    TEST_STEP("Create testpmd jobs on IUT and TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running testpmd on IUT");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&iut_testpmd_job,
+                                              &iut_link_speed));
+
+    TEST_STEP("Retrieve IUT Rx and Tx stats");
+    CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_tx));
+    CHECK_RC(test_testpmd_get_stats_many_ports(iut_jobs_ctrl, &test_params,
+                                               &iut_testpmd_job, 1,
+                                               &n_ports_found, &port,
+                                               &iut_stats_tx,
+                                               &iut_stats_rx));
+
+    TEST_STEP("Check and log measurement results");
+    if (iut_stats_rx.data.mean == 0 || iut_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    te_mi_logger_add_comment(logger, NULL, "hugepage_size", "%ukB",
+                             hugepage_size);
+    te_mi_logger_add_comment(logger, NULL, "iova_mode", "%s", iova_mode);
+    te_mi_logger_add_comment(logger, NULL, "iommu", "%s", iommu);
+    te_mi_logger_destroy(logger);
+    logger = NULL;
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx,
+                         packet_size, iut_link_speed, "Rx");
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_tx,
+                         packet_size, iut_link_speed, "FwdTx");
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_mi_logger_destroy(logger);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+
+    if (extra_eal_args != NULL)
+    {
+        CLEANUP_CHECK_RC(cfg_set_instance_fmt(CFG_VAL(STRING, extra_eal_args),
+                                              TEST_EXTRA_EAL_ARGS_OID_FMT,
+                                              iut_jobs_ctrl->ta));
+    }
+    if (mounted)
+    {
+        CLEANUP_CHECK_RC(test_run_agent_cmd(iut_jobs_ctrl,
+                                            "umount %s && rmdir %s",
+                                            huge_dir.ptr, huge_dir.ptr));
+    }
+
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&iut_stats_rx);
+    te_meas_stats_free(&iut_stats_tx);
+    te_string_free(&huge_dir);
+    te_string_free(&eal_args);
+    free(extra_eal_args);
+    free(iommu);
+    free(iut_mac);
+
+    TEST_END;
+}
+/** @} */
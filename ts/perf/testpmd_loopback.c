@@ -50,6 +50,10 @@ main(int argc, char *argv[])
     te_meas_stats_t meas_stats_tx = {0};
     te_meas_stats_t meas_stats_rx = {0};
 
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    double cycles;
+
     te_bool dbells_supp;
     te_kvpair_h dbells_opt;
     te_kvpair_init(&dbells_opt);
@@ -85,6 +89,9 @@ main(int argc, char *argv[])
         CHECK_RC(tapi_dpdk_add_tx_dbells_display(&test_params, "1"));
     }
 
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+
     TEST_STEP("Create testpmd job");
     CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_fwd_cores,
                                           &prop, &test_params, &testpmd_job));
@@ -96,13 +103,21 @@ main(int argc, char *argv[])
         TEST_STEP("Attach doorbells filters");
         CHECK_RC(tapi_dpdk_attach_dbells_filter_tx(&testpmd_job));
     }
+
+    if (cycles_supp)
+    {
+        TEST_STEP("Attach CPU cycles filter");
+        CHECK_RC(test_attach_core_cycles_filter(&testpmd_job,
+                                                &cycles_filter));
+    }
+
     CHECK_RC(tapi_dpdk_testpmd_start(&testpmd_job));
 
     TEST_STEP("Retrieve link speed from running testpmd");
     CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&testpmd_job, &link_speed));
 
     TEST_STEP("Initialize Tx and Rx statistics");
-    CHECK_RC(test_meas_stats_init(&meas_stats_tx));
+    CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_tx));
     CHECK_RC(te_meas_stats_init(&meas_stats_rx, TEST_MEAS_MIN_NUM_DATAPOINTS,
                                 0, 0, 0, 0, 0));
 
@@ -114,12 +129,20 @@ main(int argc, char *argv[])
     if (meas_stats_tx.data.mean == 0 || meas_stats_rx.data.mean == 0)
         TEST_VERDICT("Failure: zero Rx or Tx packets per second");
 
-    tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_tx,
-                              packet_size, link_speed, NULL);
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_tx,
+                         packet_size, link_speed, NULL);
 
     if (dbells_supp)
         CHECK_RC(tapi_dpdk_stats_log_tx_dbells(&testpmd_job, &meas_stats_tx));
 
+    if (cycles_supp)
+    {
+        TEST_STEP("Stop testpmd and log CPU cycles per packet");
+        CHECK_RC(test_stop_testpmd(&testpmd_job));
+        CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter, &cycles));
+        test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles, "Cycles");
+    }
+
     TEST_SUCCESS;
 
 cleanup:
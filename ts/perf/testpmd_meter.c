@@ -0,0 +1,316 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_meter Test flow based metering accuracy and performance
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test how accurately meters attached to flow rules by
+ *            METER action police traffic and how forwarding rate
+ *            depends on the number of meters
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS
+ * @param n_cores           The number of IUT testpmd cores
+ * @param n_meters          The number of meters, power of two, each
+ *                          polices its own share of flows
+ * @param algorithm         Meter algorithm:
+ *                          - @c srtcm_rfc2697
+ *                          - @c trtcm_rfc2698
+ * @param cir               Committed information rate of each meter,
+ *                          Mbit/s
+ * @param pir               Peak information rate of each meter for
+ *                          @c trtcm_rfc2698, Mbit/s
+ * @param bucket_size       Size of each token bucket, bytes
+ * @param pass_yellow       Forward yellow packets if @c TRUE, drop them
+ *                          otherwise; red packets are always dropped
+ * @param max_deviation     Maximum allowed deviation of forwarded rate
+ *                          from the expected one, percents
+ *
+ * @type performance
+ *
+ * testpmd on IUT returns traffic in IO mode to the traffic generator and
+ * the generator Rx rate is the rate of packets which pass the meters.
+ * Iterations with and without passing yellow packets give green and
+ * yellow shares of the traffic, the rest is red.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_meter"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "te_mi_log.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** The number of flows generated by traffic generator */
+#define TEST_GENERATOR_FLOWS 1024
+
+/** Maximum number of meters, flows are split by destination IPv4 octet */
+#define TEST_MAX_METERS 256
+
+#define TEST_METER_PROFILE_ID 0
+#define TEST_METER_POLICY_ID 0
+
+/**
+ * Append testpmd commands creating meters and flow rules with METER
+ * action.
+ */
+static void
+test_append_meters(te_string *cmds, const char *algorithm,
+                   unsigned long long cir, unsigned long long pir,
+                   unsigned int bucket_size, te_bool pass_yellow,
+                   unsigned int n_meters)
+{
+    unsigned int i;
+
+    /* Rates are specified in bytes per second */
+    if (strcmp(algorithm, "srtcm_rfc2697") == 0)
+    {
+        te_string_append(cmds,
+                         "add port meter profile srtcm_rfc2697 0 %d %llu "
+                         "%u %u 0\n", TEST_METER_PROFILE_ID, cir,
+                         bucket_size, bucket_size);
+    }
+    else
+    {
+        te_string_append(cmds,
+                         "add port meter profile trtcm_rfc2698 0 %d %llu "
+                         "%llu %u %u 0\n", TEST_METER_PROFILE_ID, cir, pir,
+                         bucket_size, bucket_size);
+    }
+
+    te_string_append(cmds,
+                     "add port meter policy 0 %d "
+                     "g_actions queue index 0 / end "
+                     "y_actions %s / end "
+                     "r_actions drop / end\n", TEST_METER_POLICY_ID,
+                     pass_yellow ? "queue index 0" : "drop");
+
+    for (i = 0; i < n_meters; i++)
+    {
+        te_string_append(cmds, "create port meter 0 %u %d %d yes 0 0 0\n",
+                         i, TEST_METER_PROFILE_ID, TEST_METER_POLICY_ID);
+        te_string_append(cmds,
+                         "flow create 0 ingress pattern eth / ipv4 "
+                         "dst spec 0.0.0.%u dst mask 0.0.0.%u / end "
+                         "actions meter mtr_id %u / end\n",
+                         i, n_meters - 1, i);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int n_tst_ports = 0;
+    unsigned int tst_port = 0;
+    unsigned int tst_link_speed = 0;
+    te_meas_stats_t tst_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+    te_mi_logger *logger = NULL;
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    const char *algorithm;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int n_meters;
+    unsigned int cir;
+    unsigned int pir;
+    unsigned int bucket_size;
+    unsigned int max_deviation;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    te_bool pass_yellow;
+    te_bool trtcm;
+    const char *txpkts;
+    char *iut_mac;
+    double offered_pps;
+    double passed_pps;
+    double expected_pps;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_STRING_PARAM(algorithm);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_UINT_PARAM(n_meters);
+    TEST_GET_UINT_PARAM(cir);
+    TEST_GET_UINT_PARAM(pir);
+    TEST_GET_UINT_PARAM(bucket_size);
+    TEST_GET_BOOL_PARAM(pass_yellow);
+    TEST_GET_UINT_PARAM(max_deviation);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    if (n_meters == 0 || n_meters > TEST_MAX_METERS ||
+        (n_meters & (n_meters - 1)) != 0)
+        TEST_VERDICT("The number of meters must be a power of two up to %u",
+                     TEST_MAX_METERS);
+
+    trtcm = (strcmp(algorithm, "trtcm_rfc2698") == 0);
+    if (!trtcm && strcmp(algorithm, "srtcm_rfc2697") != 0)
+        TEST_VERDICT("Unknown meter algorithm '%s'", algorithm);
+    if (trtcm && pir < cir)
+        TEST_VERDICT("Peak rate must not be less than committed one");
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "flowgen_flows",
+                           "%u", TEST_GENERATOR_FLOWS));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+    free(iut_mac);
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to return traffic to the port "
+              "it is received on");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "port_topology",
+                           "loop"));
+
+    TEST_STEP("Create testpmd job to forward traffic on IUT");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+
+    TEST_STEP("Create meter profile, policy dropping red and optionally "
+              "yellow packets, @p n_meters meters and a flow rule with "
+              "METER action per meter");
+    test_append_meters(&iut_testpmd_job.cmdline_setup, algorithm,
+                       (unsigned long long)cir * 1000000 / 8,
+                       (unsigned long long)pir * 1000000 / 8,
+                       bucket_size, pass_yellow, n_meters);
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed_many_ports(&tst_testpmd_job, 1,
+                                                         &n_tst_ports,
+                                                         &tst_port,
+                                                         &tst_link_speed));
+
+    TEST_STEP("Initialize TST Rx and Tx statistics");
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+
+    TEST_STEP("Retrieve offered and passed rates from traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         &tst_stats_rx));
+
+    TEST_STEP("Check and log measurement results");
+    if (tst_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx packets per second");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         packet_size, tst_link_speed, "Tx");
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx,
+                         packet_size, tst_link_speed,
+                         pass_yellow ? "GreenYellowRx" : "GreenRx");
+
+    /*
+     * Offered load is split equally between meters. In the long run
+     * srTCM passes CIR as green and nothing as yellow, trTCM passes
+     * CIR as green and (PIR - CIR) as yellow.
+     */
+    offered_pps = tst_stats_tx.data.mean;
+    passed_pps = tst_stats_rx.data.mean;
+    expected_pps = (double)((pass_yellow && trtcm) ? pir : cir) *
+                   1000000 / 8 / packet_size;
+    expected_pps = MIN(expected_pps, offered_pps / n_meters) * n_meters;
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "algorithm", "%s", algorithm);
+    te_mi_logger_add_meas_key(logger, NULL, "meters", "%u", n_meters);
+    te_mi_logger_add_meas_key(logger, NULL, "pass_yellow", "%s",
+                              pass_yellow ? "TRUE" : "FALSE");
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "expected",
+                          TE_MI_MEAS_AGGR_SINGLE, expected_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "passed",
+                          TE_MI_MEAS_AGGR_MEAN, passed_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "dropped",
+                          TE_MI_MEAS_AGGR_MEAN, offered_pps - passed_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_destroy(logger);
+
+    RING("%u meters: offered %.0f pps, passed %.0f pps, expected %.0f pps",
+         n_meters, offered_pps, passed_pps, expected_pps);
+
+    if (passed_pps * 100 > expected_pps * (100 + max_deviation))
+        TEST_VERDICT("Meters pass more traffic than expected");
+    /* Forwarding of unpoliced traffic may be limited by IUT itself */
+    if (expected_pps < offered_pps &&
+        passed_pps * 100 < expected_pps * (100 - max_deviation))
+        TEST_VERDICT("Meters pass less traffic than expected");
+
+    TEST_SUCCESS;
+
+cleanup:
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&tst_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+
+    TEST_END;
+}
+/** @} */
@@ -0,0 +1,429 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_numa Test NUMA locality impact on forwarding
+ * @ingroup perf
+ * @{
+ *
+ * @objective Compare dpdk-testpmd IO forwarding performance when
+ *            forwarding cores and mbuf pool are local or remote to
+ *            the NIC NUMA node
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Packet size without FCS as generated
+ * @param n_cores           The number of IUT testpmd cores
+ * @param testpmd_arg_rxq   The number of Rx and Tx queues
+ *
+ * @type performance
+ *
+ * The same workload is measured in three placements one after another
+ * while the traffic generator is running:
+ * - @c local forwarding cores and mbuf pool on the NIC NUMA node;
+ * - @c remote_lcores forwarding cores on another NUMA node;
+ * - @c remote_mempool mbuf pool and rings on another NUMA node.
+ *
+ * Forwarding cores placement is controlled by grabbing CPUs of NUMA
+ * nodes which must not be used before testpmd job is created. NUMA nodes
+ * of forwarding cores reported by testpmd are checked.
+ * CPU cycles per packet are used as a per-packet latency estimate.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_numa"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_cfg_net.h"
+#include "tapi_cfg_pci.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** NUMA placements of forwarding cores and mbuf pool */
+enum test_numa_placement {
+    TEST_NUMA_LOCAL,
+    TEST_NUMA_REMOTE_LCORES,
+    TEST_NUMA_REMOTE_MEMPOOL,
+    TEST_NUMA_N_PLACEMENTS,
+};
+
+/** Placement names used in logs */
+static const char *test_numa_placement_names[TEST_NUMA_N_PLACEMENTS] = {
+    "Local",
+    "RemoteLcores",
+    "RemoteMempool",
+};
+
+/**
+ * Grab or release all CPU threads either on the given NUMA node or
+ * on other nodes to make testpmd use CPUs of the desired node.
+ *
+ * @param ta            Test agent name
+ * @param n_threads     The number of CPU threads
+ * @param threads       CPU threads
+ * @param grabbed       Per-thread flags of grabbed CPU threads
+ * @param node          NUMA node
+ * @param on_node       Grab or release CPU threads on @p node if @c TRUE,
+ *                      on other nodes otherwise
+ * @param grab          Grab CPU threads if @c TRUE, release otherwise
+ */
+static void
+test_numa_grab_cpus(const char *ta, size_t n_threads,
+                    tapi_cpu_index_t *threads, te_bool *grabbed,
+                    unsigned int node, te_bool on_node, te_bool grab)
+{
+    size_t i;
+
+    for (i = 0; i < n_threads; i++)
+    {
+        if ((threads[i].node_id == node) != on_node)
+            continue;
+
+        if (grab)
+        {
+            /* CPUs already grabbed by others are just skipped */
+            grabbed[i] = (tapi_cfg_cpu_grab_by_id(ta, &threads[i]) == 0);
+        }
+        else if (grabbed[i])
+        {
+            CHECK_RC(tapi_cfg_cpu_release_by_id(ta, &threads[i]));
+            grabbed[i] = FALSE;
+        }
+    }
+}
+
+/**
+ * Attach filter to get forwarding lcores with their NUMA nodes which
+ * testpmd reports on forwarding start.
+ *
+ * @param job           testpmd job which is not started yet
+ * @param[out] filter   Attached filter
+ */
+static void
+test_numa_attach_lcores_filter(tapi_dpdk_testpmd_job_t *job,
+                               tapi_job_channel_t **filter)
+{
+    CHECK_RC(tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                    "Forwarding lcores", TRUE, 0, filter));
+    CHECK_RC(tapi_job_filter_add_regexp(*filter,
+                "Logical Core ([0-9]+ \\(socket [0-9]+\\)) forwards", 1));
+}
+
+/**
+ * Log forwarding lcores picked for running testpmd and check that they
+ * are on the NIC NUMA node or on other nodes as required.
+ *
+ * @param filter        Filter attached by test_numa_attach_lcores_filter()
+ * @param nic_node      NIC NUMA node
+ * @param on_nic_node   Whether lcores must be on @p nic_node
+ * @param name          Placement name
+ */
+static void
+test_numa_check_lcores(tapi_job_channel_t *filter, unsigned int nic_node,
+                       te_bool on_nic_node, const char *name)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    te_string lcores = TE_STRING_INIT;
+    te_bool misplaced = FALSE;
+    unsigned int lcore;
+    unsigned int node;
+
+    while (tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter), 0, &buf) == 0 &&
+           !buf.eos)
+    {
+        if (sscanf(buf.data.ptr, "%u (socket %u)", &lcore, &node) != 2)
+            TEST_FAIL("Cannot parse forwarding lcore '%s'", buf.data.ptr);
+
+        te_string_append(&lcores, "%s%u@%u", lcores.len == 0 ? "" : ",",
+                         lcore, node);
+        if ((node == nic_node) != on_nic_node)
+            misplaced = TRUE;
+        te_string_reset(&buf.data);
+    }
+    te_string_free(&buf.data);
+
+    if (lcores.len == 0)
+        TEST_FAIL("testpmd does not report forwarding lcores");
+
+    RING("%s placement: forwarding lcores@nodes %s, NIC node %u",
+         name, lcores.ptr, nic_node);
+    te_string_free(&lcores);
+
+    if (misplaced)
+    {
+        TEST_VERDICT("Forwarding lcores are not placed as required in %s "
+                     "placement", name);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const tapi_env_if *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int iut_link_speed = 0;
+    te_meas_stats_t iut_stats_rx = {0};
+    te_meas_stats_t iut_stats_tx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+    tapi_cpu_index_t *threads = NULL;
+    te_bool *grabbed = NULL;
+    size_t n_threads = 0;
+    unsigned int n_pci = 0;
+    char **pci_oids = NULL;
+    unsigned int nic_node;
+    unsigned int remote_node = 0;
+    te_bool remote_found = FALSE;
+
+    const char *generator_mode;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    const char *txpkts;
+    char *iut_mac = NULL;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    tapi_job_channel_t *lcores_filter = NULL;
+    double rates[TEST_NUMA_N_PLACEMENTS] = {0};
+    double cycles[TEST_NUMA_N_PLACEMENTS] = {0};
+    te_string title = TE_STRING_INIT;
+    te_mi_logger *logger = NULL;
+    unsigned int placement;
+    size_t i;
+    te_errno rc;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_ENV_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    TEST_STEP("Find NUMA node of the IUT NIC and a remote NUMA node");
+    if (test_is_vdev(iut_port->if_info.if_name))
+        TEST_SKIP("NUMA placement of virtual devices is not defined");
+
+    CHECK_RC(tapi_cfg_net_node_get_pci_oids(
+                tapi_env_get_if_net_node(iut_port), &n_pci, &pci_oids));
+    if (n_pci == 0)
+        TEST_SKIP("PCI device of IUT port is not found");
+    CHECK_RC(tapi_cfg_pci_get_numa_node_id(pci_oids[0], &nic_node));
+
+    CHECK_RC(tapi_cfg_get_all_threads(iut_jobs_ctrl->ta, &n_threads,
+                                      &threads));
+    for (i = 0; i < n_threads; i++)
+    {
+        if (threads[i].node_id != nic_node)
+        {
+            remote_node = threads[i].node_id;
+            remote_found = TRUE;
+            break;
+        }
+    }
+    if (!remote_found)
+        TEST_SKIP("IUT host has a single NUMA node");
+    grabbed = tapi_calloc(n_threads, sizeof(*grabbed));
+
+    RING("IUT NIC is on NUMA node %u, remote node is %u", nic_node,
+         remote_node);
+
+    test_check_mtu(iut_jobs_ctrl, &iut_port->if_info, packet_size);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, TRUE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to use all forwarding cores");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "txq", "%s",
+                           TEST_STRING_PARAM(testpmd_arg_rxq)));
+
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+
+    TEST_STEP("Start traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Measure forwarding performance in each NUMA placement");
+    for (placement = 0; placement < TEST_NUMA_N_PLACEMENTS; placement++)
+    {
+        TEST_SUBSTEP("Make CPUs of the wrong NUMA node unavailable and "
+                     "create testpmd job");
+        if (placement == TEST_NUMA_REMOTE_MEMPOOL)
+        {
+            /* The placement is the last one, so parameters may be changed */
+            CHECK_RC(te_kvpair_add(&test_params,
+                                   TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                   "port_numa_config", "(0,%u)",
+                                   remote_node));
+            CHECK_RC(te_kvpair_add(&test_params,
+                                   TAPI_DPDK_TESTPMD_ARG_PREFIX
+                                   "ring_numa_config", "(0,3,%u)",
+                                   remote_node));
+        }
+
+        /* Occupy CPUs of the node testpmd must not use */
+        test_numa_grab_cpus(iut_jobs_ctrl->ta, n_threads, threads, grabbed,
+                            nic_node,
+                            placement == TEST_NUMA_REMOTE_LCORES, TRUE);
+        rc = tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job);
+        test_numa_grab_cpus(iut_jobs_ctrl->ta, n_threads, threads, grabbed,
+                            nic_node,
+                            placement == TEST_NUMA_REMOTE_LCORES, FALSE);
+        if (rc != 0)
+        {
+            TEST_SKIP("Failed to create testpmd job with forwarding cores "
+                      "in %s placement", test_numa_placement_names[placement]);
+        }
+
+        if (cycles_supp)
+            CHECK_RC(test_attach_core_cycles_filter(&iut_testpmd_job,
+                                                    &cycles_filter));
+        test_numa_attach_lcores_filter(&iut_testpmd_job, &lcores_filter);
+
+        TEST_SUBSTEP("Start testpmd and retrieve its Rx and Tx stats");
+        CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+        CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&iut_testpmd_job,
+                                                  &iut_link_speed));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_tx));
+        CHECK_RC(tapi_dpdk_testpmd_get_stats(&iut_testpmd_job, &iut_stats_tx,
+                                             &iut_stats_rx));
+
+        if (iut_stats_rx.data.mean == 0 || iut_stats_tx.data.mean == 0)
+            TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+        TEST_SUBSTEP("Log forwarding lcores picked for testpmd and check "
+                     "their NUMA nodes");
+        test_numa_check_lcores(lcores_filter, nic_node,
+                               placement != TEST_NUMA_REMOTE_LCORES,
+                               test_numa_placement_names[placement]);
+
+        te_string_reset(&title);
+        te_string_append(&title, "%sFwdTx",
+                         test_numa_placement_names[placement]);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_tx,
+                             packet_size, iut_link_speed,
+                             te_string_value(&title));
+        rates[placement] = iut_stats_tx.data.mean;
+
+        TEST_SUBSTEP("Stop testpmd and get CPU cycles per packet");
+        if (cycles_supp)
+        {
+            CHECK_RC(test_stop_testpmd(&iut_testpmd_job));
+            CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter,
+                                                  &cycles[placement]));
+            te_string_reset(&title);
+            te_string_append(&title, "%sCycles",
+                             test_numa_placement_names[placement]);
+            test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles[placement],
+                                 te_string_value(&title));
+        }
+
+        tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+        memset(&iut_testpmd_job, 0, sizeof(iut_testpmd_job));
+        te_meas_stats_free(&iut_stats_rx);
+        te_meas_stats_free(&iut_stats_tx);
+    }
+
+    TEST_STEP("Log throughput and per-packet latency penalties of remote "
+              "placements relative to the local one");
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    for (placement = TEST_NUMA_LOCAL + 1; placement < TEST_NUMA_N_PLACEMENTS;
+         placement++)
+    {
+        double rate_penalty = 100 * (1 - rates[placement] /
+                                         rates[TEST_NUMA_LOCAL]);
+
+        te_string_reset(&title);
+        te_string_append(&title, "%sThroughputPenalty",
+                         test_numa_placement_names[placement]);
+        te_mi_logger_add_comment(logger, NULL, te_string_value(&title),
+                                 "%.2f%%", rate_penalty);
+        RING("%s: %.2f%%", te_string_value(&title), rate_penalty);
+
+        if (cycles_supp && cycles[TEST_NUMA_LOCAL] > 0)
+        {
+            double latency_penalty = 100 * (cycles[placement] /
+                                            cycles[TEST_NUMA_LOCAL] - 1);
+
+            te_string_reset(&title);
+            te_string_append(&title, "%sLatencyPenalty",
+                             test_numa_placement_names[placement]);
+            te_mi_logger_add_comment(logger, NULL, te_string_value(&title),
+                                     "%.2f%%", latency_penalty);
+            RING("%s: %.2f%%", te_string_value(&title), latency_penalty);
+        }
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_mi_logger_destroy(logger);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&iut_stats_rx);
+    te_meas_stats_free(&iut_stats_tx);
+    for (i = 0; i < n_pci; i++)
+        free(pci_oids[i]);
+    free(pci_oids);
+    free(threads);
+    free(grabbed);
+    free(iut_mac);
+    te_string_free(&title);
+
+    TEST_END;
+}
+/** @} */
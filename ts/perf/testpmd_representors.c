@@ -0,0 +1,456 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_representors Test port representors slow path performance
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test dpdk-testpmd performance when it forwards traffic
+ *            from the uplink port to port representors and compare it
+ *            with the case when the forwarding is offloaded
+ *
+ * @param generator_mode    Traffic generator mode, only @c flowgen
+ * @param packet_size       Packet size without FCS
+ * @param n_reps            The number of port representors to plug
+ * @param n_cores           The number of IUT testpmd cores
+ * @param offload           Offload the forwarding from the uplink to
+ *                          VFs using transfer flow rules
+ *
+ * @type performance
+ *
+ * The traffic generator sends @p n_reps flows to 10.253.0.0 + N. Transfer
+ * flow rules steer flow N received on the uplink (PF) to representor N,
+ * so the traffic is delivered to testpmd through all representors, i.e.
+ * takes the slow path. testpmd forwards it in IO mode using paired port
+ * topology over the first VF, the uplink and the representors, so each
+ * representor sends the flow it receives to a VF via its pair. Rates of
+ * each representor and their sum are reported. The first VF is attached
+ * to the same testpmd after the representors, so its Rx rate is the rate
+ * delivered to one VF by either the slow or the offloaded path. The VF
+ * is paired with the uplink, so what it receives leaves IUT instead of
+ * returning to its representor. Port rates are read from DPDK telemetry
+ * socket since testpmd does not report all ports in periodic statistics.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_representors"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_cfg_pci.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/** Destination address of the first flow generated in flowgen mode */
+#define TEST_FLOW_DST_ADDR 0x0afd0000U /* 10.253.0.0 */
+
+/** Format IPv4 address given in host byte order */
+#define TEST_IPV4_FMT "%u.%u.%u.%u"
+#define TEST_IPV4_ARGS(_addr) \
+    ((_addr) >> 24) & 0xff, ((_addr) >> 16) & 0xff, \
+    ((_addr) >> 8) & 0xff, (_addr) & 0xff
+
+/**
+ * Maximum share of the offered load, percents, which is allowed to
+ * reach representors when the forwarding is offloaded
+ */
+#define TEST_OFFLOAD_MAX_SLOW_PATH_SHARE 1
+
+/** Default interval of port statistics sampling from telemetry socket */
+#define TEST_PORT_STATS_INTERVAL_MS 1000
+
+/**
+ * Log Rx and Tx rates of each representor and their sums.
+ *
+ * @param n_reps        The number of representors
+ * @param rep_rx        Rx statistics of representors
+ * @param rep_tx        Tx statistics of representors
+ * @param packet_size   Packet size without FCS
+ * @param link_speed    Uplink link speed
+ */
+static void
+test_log_rep_rates(unsigned int n_reps, te_meas_stats_t *rep_rx,
+                   te_meas_stats_t *rep_tx, unsigned int packet_size,
+                   unsigned int link_speed)
+{
+    te_string title = TE_STRING_INIT;
+    te_mi_logger *logger;
+    double aggr_rx_pps = 0;
+    double aggr_tx_pps = 0;
+    unsigned int rep;
+
+    for (rep = 0; rep < n_reps; rep++)
+    {
+        te_string_reset(&title);
+        te_string_append(&title, "Rep%uRx", rep);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &rep_rx[rep],
+                             packet_size, link_speed,
+                             te_string_value(&title));
+
+        te_string_reset(&title);
+        te_string_append(&title, "Rep%uTx", rep);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &rep_tx[rep],
+                             packet_size, link_speed,
+                             te_string_value(&title));
+
+        aggr_rx_pps += rep_rx[rep].data.mean;
+        aggr_tx_pps += rep_tx[rep].data.mean;
+    }
+
+    RING("Aggregate slow path rate over %u representors is %.3f Mpps Rx, "
+         "%.3f Mpps Tx", n_reps, aggr_rx_pps / 1e6, aggr_tx_pps / 1e6);
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "RepRxAggr",
+                          TE_MI_MEAS_AGGR_MEAN, aggr_rx_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "RepTxAggr",
+                          TE_MI_MEAS_AGGR_MEAN, aggr_tx_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_destroy(logger);
+    te_string_free(&title);
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int n_iut_ports = 0;
+    unsigned int n_tst_ports = 0;
+    unsigned int iut_uplink = 0;
+    unsigned int tst_port = 0;
+    unsigned int iut_link_speed;
+    unsigned int tst_link_speed;
+    /* Representors and the VF statistics, the VF is the last one */
+    unsigned int *stats_ports = NULL;
+    te_meas_stats_t *iut_stats_rx = NULL;
+    te_meas_stats_t *iut_stats_tx = NULL;
+    te_meas_stats_t tst_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+    const char *interval_str;
+    unsigned int interval_ms = TEST_PORT_STATS_INTERVAL_MS;
+    unsigned int vf_port;
+    double slow_path_pps = 0;
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    unsigned int n_reps;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int max_vfs;
+    unsigned int n_vfs_init = 0;
+    te_bool vfs_enabled = FALSE;
+    cfg_oid **vf_oids = NULL;
+    unsigned int n_vf_oids = 0;
+    char *vf_addr = NULL;
+    char *vf_oid = NULL;
+    char *vf_driver = NULL;
+    char *vf_dev_args = NULL;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    te_bool offload;
+    const char *txpkts;
+    char *pf_oid = NULL;
+    char *dev_args = NULL;
+    char *iut_mac;
+    unsigned int port;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_reps);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_BOOL_PARAM(offload);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    if (n_reps == 0)
+        TEST_VERDICT("At least one representor is required");
+    /* Flow rules are generated for flows of flowgen mode only */
+    if (strcmp(generator_mode, "flowgen") != 0)
+        TEST_FAIL("Generator mode '%s' is not supported", generator_mode);
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    TEST_STEP("Enable @p n_reps VFs of the IUT PF");
+    /* IUT port is assumed to be a PCI function named by its address */
+    CHECK_RC(tapi_cfg_pci_oid_by_addr(iut_jobs_ctrl->ta, iut_port->if_name,
+                                      &pf_oid));
+    CHECK_RC(tapi_cfg_pci_get_max_vfs_of_pf(pf_oid, &max_vfs));
+    if (max_vfs < n_reps)
+        TEST_SKIP("The PF supports only %u VFs", max_vfs);
+    CHECK_RC(tapi_cfg_pci_get_vfs_of_pf(pf_oid, TRUE, &n_vfs_init,
+                                        &vf_oids, NULL));
+    if (n_vfs_init < n_reps)
+    {
+        vfs_enabled = TRUE;
+        CHECK_RC_VERDICT(tapi_cfg_pci_enable_vfs_of_pf(pf_oid, n_reps),
+                         "Failed to enable VFs");
+        for (port = 0; port < n_vfs_init; port++)
+            cfg_free_oid(vf_oids[port]);
+        free(vf_oids);
+        CHECK_RC(tapi_cfg_pci_get_vfs_of_pf(pf_oid, TRUE, &n_vf_oids,
+                                            &vf_oids, NULL));
+    }
+    else
+    {
+        n_vf_oids = n_vfs_init;
+    }
+
+    TEST_STEP("Bind the first VF to DPDK driver to receive traffic "
+              "delivered to it");
+    CHECK_RC(tapi_cfg_pci_addr_by_oid(vf_oids[0], &vf_addr));
+    CHECK_RC(tapi_cfg_pci_oid_by_addr(iut_jobs_ctrl->ta, vf_addr, &vf_oid));
+    CHECK_RC(tapi_cfg_pci_get_driver(vf_oid, &vf_driver));
+    CHECK_RC_VERDICT(tapi_cfg_pci_bind_ta_driver_on_device(iut_jobs_ctrl->ta,
+                                                           NET_DRIVER_TYPE_DPDK,
+                                                           vf_addr),
+                     "Failed to bind VF to DPDK driver");
+
+    TEST_STEP("Prepare traffic generator parameters to generate @p n_reps "
+              "flows");
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "flowgen_flows",
+                           "%u", n_reps));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+    free(iut_mac);
+
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size, &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "port_topology",
+                           "paired"));
+
+    TEST_STEP("Create testpmd job to forward traffic on IUT");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+
+    TEST_STEP("Make testpmd plug @p n_reps representors of the PF and "
+              "the first VF");
+    CHECK_RC(tapi_rte_get_dev_args_by_pci_addr(iut_jobs_ctrl->ta,
+                                               iut_port->if_name, &dev_args));
+    CHECK_RC(tapi_rte_get_dev_args_by_pci_addr(iut_jobs_ctrl->ta, vf_addr,
+                                               &vf_dev_args));
+    te_string_append(&iut_testpmd_job.cmdline_setup,
+                     "port attach %s,%s%srepresentor=[0-%u]\n"
+                     "port attach %s%s%s\n"
+                     "port start all\n", iut_port->if_name,
+                     dev_args == NULL ? "" : dev_args,
+                     dev_args == NULL ? "" : ",", n_reps - 1,
+                     vf_addr, vf_dev_args == NULL ? "" : ",",
+                     vf_dev_args == NULL ? "" : vf_dev_args);
+    /* Uplink is port 0, representors follow it, then the VF is attached */
+    vf_port = n_reps + 1;
+
+    TEST_STEP("Make testpmd forward over the first VF, the uplink and "
+              "all representors in paired port topology");
+    te_string_append(&iut_testpmd_job.cmdline_setup, "set portlist %u,0",
+                     vf_port);
+    for (port = 1; port <= n_reps; port++)
+        te_string_append(&iut_testpmd_job.cmdline_setup, ",%u", port);
+    te_string_append(&iut_testpmd_job.cmdline_setup, "\n");
+
+    TEST_STEP("Add transfer flow rules to direct flow N received on the "
+              "uplink either to representor N if @p offload is @c FALSE, "
+              "or to VF N in HW otherwise");
+    for (port = 1; port <= n_reps; port++)
+    {
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 transfer pattern represented_port "
+                         "ethdev_port_id is 0 / eth / ipv4 dst is "
+                         TEST_IPV4_FMT " / end actions %s %u / end\n",
+                         TEST_IPV4_ARGS(TEST_FLOW_DST_ADDR + port - 1),
+                         offload ? "represented_port ethdev_port_id" :
+                                   "port_representor port_id", port);
+    }
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running testpmd-s");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed_many_ports(&iut_testpmd_job,
+                                                         1, &n_iut_ports,
+                                                         &iut_uplink,
+                                                         &iut_link_speed));
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed_many_ports(&tst_testpmd_job,
+                                                         1, &n_tst_ports,
+                                                         &tst_port,
+                                                         &tst_link_speed));
+
+    TEST_STEP("Initialize statistics");
+    stats_ports = tapi_calloc(n_reps + 1, sizeof(*stats_ports));
+    iut_stats_rx = tapi_calloc(n_reps + 1, sizeof(*iut_stats_rx));
+    iut_stats_tx = tapi_calloc(n_reps + 1, sizeof(*iut_stats_tx));
+    for (port = 0; port <= n_reps; port++)
+    {
+        stats_ports[port] = port + 1;
+        if (offload && port < n_reps)
+        {
+            /* Stabilization is not expected for (almost) zero rates */
+            CHECK_RC(te_meas_stats_init(&iut_stats_rx[port],
+                                        TEST_MEAS_MIN_NUM_DATAPOINTS, 0,
+                                        TEST_MEAS_MIN_NUM_DATAPOINTS,
+                                        TEST_MEAS_REQUIRED_CV,
+                                        TEST_MEAS_ALLOWED_SKIPS,
+                                        TEST_MEAS_DEVIATION_COEFF));
+            CHECK_RC(te_meas_stats_init(&iut_stats_tx[port],
+                                        TEST_MEAS_MIN_NUM_DATAPOINTS, 0,
+                                        TEST_MEAS_MIN_NUM_DATAPOINTS,
+                                        TEST_MEAS_REQUIRED_CV,
+                                        TEST_MEAS_ALLOWED_SKIPS,
+                                        TEST_MEAS_DEVIATION_COEFF));
+        }
+        else
+        {
+            CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx[port]));
+            CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_tx[port]));
+        }
+    }
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+
+    TEST_STEP("Retrieve Tx stats from running traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         &tst_stats_rx));
+
+    TEST_STEP("Retrieve representors and the first VF rates from IUT "
+              "telemetry socket");
+    interval_str = getenv("TE_TELEMETRY_STATS_INTERVAL");
+    if (interval_str != NULL)
+        CHECK_RC(te_strtoui(interval_str, 0, &interval_ms));
+    CHECK_RC(test_telemetry_get_stats_ports(iut_jobs_ctrl, "testpmd",
+                                            interval_ms, n_reps + 1,
+                                            stats_ports, iut_stats_tx,
+                                            iut_stats_rx));
+    if (iut_stats_rx[n_reps].data.mean == 0 || tst_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         packet_size, tst_link_speed, "Tx");
+
+    for (port = 0; port < n_reps; port++)
+        slow_path_pps += iut_stats_rx[port].data.mean;
+
+    if (offload)
+    {
+        TEST_STEP("Check that the offloaded traffic does not reach "
+                  "representors in testpmd");
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[n_reps],
+                             packet_size, iut_link_speed, "OffloadedVfRx");
+
+        if (slow_path_pps * 100 >
+            tst_stats_tx.data.mean * TEST_OFFLOAD_MAX_SLOW_PATH_SHARE)
+            TEST_VERDICT("Traffic is not offloaded from the slow path");
+
+        TEST_SUCCESS;
+    }
+
+    TEST_STEP("Check and log per representor and aggregate rates");
+    if (slow_path_pps == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    /* Representors may report no link speed, use uplink one instead */
+    test_log_rep_rates(n_reps, iut_stats_rx, iut_stats_tx, packet_size,
+                       iut_link_speed);
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[n_reps],
+                         packet_size, iut_link_speed, "SlowPathVfRx");
+
+    TEST_SUCCESS;
+
+cleanup:
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+
+    if (iut_stats_rx != NULL)
+    {
+        for (port = 0; port <= n_reps; ++port)
+        {
+            te_meas_stats_free(&iut_stats_rx[port]);
+            te_meas_stats_free(&iut_stats_tx[port]);
+        }
+    }
+    free(iut_stats_rx);
+    free(iut_stats_tx);
+    free(stats_ports);
+    te_meas_stats_free(&tst_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+
+    if (vf_driver != NULL && !vfs_enabled)
+        CLEANUP_CHECK_RC(tapi_cfg_pci_bind_driver(vf_oid, vf_driver));
+    if (vfs_enabled)
+    {
+        if (n_vfs_init == 0)
+            CLEANUP_CHECK_RC(tapi_cfg_pci_disable_vfs_of_pf(pf_oid));
+        else
+            CLEANUP_CHECK_RC(tapi_cfg_pci_enable_vfs_of_pf(pf_oid,
+                                                           n_vfs_init));
+    }
+
+    for (port = 0; port < n_vf_oids; port++)
+        cfg_free_oid(vf_oids[port]);
+    free(vf_oids);
+    free(vf_addr);
+    free(vf_oid);
+    free(vf_driver);
+    free(vf_dev_args);
+    free(dev_args);
+    free(pf_oid);
+
+    TEST_END;
+}
+/** @} */
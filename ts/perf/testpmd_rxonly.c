@@ -68,10 +68,25 @@ main(int argc, char *argv[])
 
     te_kvpair_h *traffic_generator_params = NULL;
 
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    double cycles;
+
+    te_bool bursts_supp;
+    tapi_job_channel_t *rx_bursts_filter = NULL;
+
+    test_perf_stat perf_stat;
+    test_perf_record perf_record;
+    double rx_pps = 0;
+    double deficit;
+
     te_bool dbells_supp;
     te_kvpair_h dbells_opt;
     te_kvpair_init(&dbells_opt);
 
+    test_perf_stat_init(&perf_stat);
+    test_perf_record_init(&perf_record);
+
     TEST_START;
     TEST_GET_PCO(iut_jobs_ctrl);
     TEST_GET_PCO(tst_jobs_ctrl);
@@ -165,6 +180,11 @@ main(int argc, char *argv[])
                                         TEST_STRING_PARAM(testpmd_arg_rxq)));
     }
 
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+    CHECK_RC(test_add_record_burst_stats(iut_jobs_ctrl, &env, &test_params,
+                                         &bursts_supp));
+
     TEST_STEP("Create testpmd job to run rxonly on IUT");
     CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_rx_cores,
                                           &prop, &test_params,
@@ -183,6 +203,23 @@ main(int argc, char *argv[])
         CHECK_RC(tapi_dpdk_attach_dbells_filter_rx(&iut_testpmd_job));
     }
 
+    if (cycles_supp)
+    {
+        TEST_STEP("Attach CPU cycles filter");
+        CHECK_RC(test_attach_core_cycles_filter(&iut_testpmd_job,
+                                                &cycles_filter));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Attach burst stats filters");
+        CHECK_RC(test_attach_burst_stats_filter(&iut_testpmd_job, TRUE,
+                                                &rx_bursts_filter));
+    }
+
+    CHECK_RC(test_perf_stat_attach(&perf_stat, iut_testpmd_job.out_chs[0]));
+    CHECK_RC(test_perf_record_attach(&perf_record, iut_testpmd_job.out_chs[0]));
+
     CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
     CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
 
@@ -198,18 +235,23 @@ main(int argc, char *argv[])
                                                          tst_ports,
                                                          tst_link_speed));
 
+    TEST_STEP("Start hardware performance counters collection and "
+              "profiling on IUT forwarding cores if requested");
+    test_perf_stat_start(&perf_stat, iut_jobs_ctrl);
+    test_perf_record_start(&perf_record, iut_jobs_ctrl);
+
     TEST_STEP("Initialize IUT Rx and TST Tx statistics");
     for (port = 0; port < n_ports; ++port)
     {
-        CHECK_RC(test_meas_stats_init(&iut_stats_rx[port]));
-        CHECK_RC(test_meas_stats_init(&tst_stats_tx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &iut_stats_rx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx[port]));
     }
 
     TEST_STEP("Retrieve Rx stats from running testpmd");
-    CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&iut_testpmd_job,
-                                                    n_ports,
-                                                    &n_iut_ports, iut_ports,
-                                                    NULL, iut_stats_rx));
+    CHECK_RC(test_testpmd_get_stats_many_ports(iut_jobs_ctrl, &test_params,
+                                               &iut_testpmd_job, n_ports,
+                                               &n_iut_ports, iut_ports,
+                                               NULL, iut_stats_rx));
 
     TEST_STEP("Retrieve Tx stats from running testpmd");
     CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&tst_testpmd_job,
@@ -224,21 +266,23 @@ main(int argc, char *argv[])
             tst_stats_tx[port].data.mean == 0)
             TEST_VERDICT("Failure: zero Tx or Rx packets per second");
 
+        rx_pps += iut_stats_rx[port].data.mean;
+
         te_string_reset(&str);
         te_string_append(&str, "Rx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[port],
-                                  packet_size, iut_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &iut_stats_rx[port],
+                             packet_size, iut_link_speed[port],
+                             te_string_value(&str));
 
         te_string_reset(&str);
         te_string_append(&str, "Tx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx[port],
-                                  packet_size, tst_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx[port],
+                             packet_size, tst_link_speed[port],
+                             te_string_value(&str));
 
         if (dbells_supp)
             CHECK_RC(tapi_dpdk_stats_log_rx_dbells(&iut_testpmd_job,
@@ -252,9 +296,39 @@ main(int argc, char *argv[])
                                        iut_link_speed, "Rx");
     }
 
+    test_perf_stat_log(&perf_stat, TAPI_DPDK_TESTPMD_NAME, rx_pps, "Rx");
+    test_perf_record_save(&perf_record, iut_jobs_ctrl, "Rx");
+
+    if (cycles_supp || bursts_supp)
+    {
+        TEST_STEP("Stop IUT testpmd to get its forwarding statistics");
+        CHECK_RC(test_stop_testpmd(&iut_testpmd_job));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Log burst sizes distribution");
+        CHECK_RC(test_log_burst_stats(TAPI_DPDK_TESTPMD_NAME,
+                                      rx_bursts_filter, "RxBursts"));
+    }
+
+    if (cycles_supp)
+    {
+        TEST_STEP("Log CPU cycles per packet");
+        CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter, &cycles));
+        test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles, "RxCycles");
+    }
+
+    TEST_STEP("Compare the rate with performance baseline");
+    if (test_perf_below_baseline(TE_TEST_NAME, packet_size, n_rx_cores, rx_pps,
+                                 &deficit))
+        TEST_VERDICT("Throughput below baseline by %.0f%%", deficit);
+
     TEST_SUCCESS;
 
 cleanup:
+    test_perf_stat_fini(&perf_stat);
+    test_perf_record_fini(&perf_record);
     tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
     tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
     te_kvpair_fini(traffic_generator_params);
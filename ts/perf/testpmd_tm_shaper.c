@@ -0,0 +1,480 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_tm_shaper Test traffic manager shaping accuracy
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test how accurately traffic manager shapers limit the rate
+ *            of dpdk-testpmd Tx only traffic and how shaping affects
+ *            Tx performance
+ *
+ * @param testpmd_command_txpkts    Packet size without FCS
+ * @param testpmd_arg_txq           The number of Tx queues, i.e. leaf nodes
+ *                                  of the hierarchy
+ * @param n_fwd_cores               The number of IUT testpmd cores
+ * @param port_rate                 Port (root node) shaper rate, Mbit/s,
+ *                                  @c 0 to disable the shaper
+ * @param queue_rate                Shaper rate of each queue (leaf node),
+ *                                  Mbit/s, @c 0 to disable the shapers
+ * @param bucket_size               Token bucket size of shapers, bytes
+ * @param max_deviation             Maximum allowed deviation of achieved
+ *                                  rate from the shaped one, percents
+ *
+ * @type performance
+ *
+ * The hierarchy consists of the port node, a single subport node and
+ * a leaf node per Tx queue. If both @p port_rate and @p queue_rate are
+ * zero, the hierarchy is not set up at all, which provides unshaped Tx
+ * performance. Otherwise unshaped Tx is run first as a reference to get
+ * CPU cycles per packet spent by shaping.
+ *
+ * Rate of each queue (leaf node) is the port rate received by the tester
+ * split according to the packets transmitted by each forwarding stream
+ * (one per Tx queue) which testpmd reports when it is stopped.
+ *
+ * @p bucket_size is swept to check that shaping accuracy does not depend
+ * on it and the bucket size in packets is logged. Burst tolerance itself
+ * is not checked: periodic statistics average rates over a second and
+ * cannot resolve bursts of a bucket size.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_tm_shaper"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "te_mi_log.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_RX_QUEUES_NUM 4
+#define TEST_TESTPMD_RX_CPUS_NUM 4
+
+/** Node IDs of non-leaf nodes, leaf node IDs are Tx queue IDs */
+#define TEST_TM_PORT_NODE_ID 1000000
+#define TEST_TM_SUBPORT_NODE_ID 900000
+
+/** Hierarchy levels */
+#define TEST_TM_LEVEL_PORT 0
+#define TEST_TM_LEVEL_SUBPORT 1
+#define TEST_TM_LEVEL_QUEUE 2
+
+/** Shaper profile IDs */
+#define TEST_TM_PORT_SHAPER_ID 0
+#define TEST_TM_QUEUE_SHAPER_ID 1
+
+/** testpmd notation of absent parent node and shaper profile */
+#define TEST_TM_NONE (-1)
+
+/** Ethernet FCS, preamble and inter-frame gap overhead per packet, bytes */
+#define TEST_ETH_L1_OVERHEAD (4 + 8 + 12)
+
+/** Runs with and without shaping */
+enum test_tm_run {
+    TEST_TM_RUN_UNSHAPED,
+    TEST_TM_RUN_SHAPED,
+    TEST_TM_N_RUNS,
+};
+
+/** Run names used in logs */
+static const char *test_tm_run_names[TEST_TM_N_RUNS] = {
+    "Unshaped",
+    "Shaped",
+};
+
+/**
+ * Attach filter to extract the number of packets transmitted by each
+ * forwarding stream which testpmd prints when forwarding is stopped.
+ * Streams are printed only if there are more streams than ports and
+ * only if they have handled some packets.
+ *
+ * @param job           testpmd job
+ * @param[out] filter   Attached filter
+ */
+static te_errno
+test_attach_stream_tx_filter(tapi_dpdk_testpmd_job_t *job,
+                             tapi_job_channel_t **filter)
+{
+    te_errno rc;
+
+    rc = tapi_job_attach_filter(TAPI_JOB_CHANNEL_SET(job->out_chs[0]),
+                                "Stream TX-packets", TRUE, 0, filter);
+    if (rc != 0)
+        return rc;
+
+    return tapi_job_filter_add_regexp(*filter,
+                    "RX-packets: +[0-9]+ +TX-packets: +([0-9]+) +TX-dropped",
+                    1);
+}
+
+/**
+ * Get the number of packets transmitted by each forwarding stream of
+ * testpmd job stopped by test_stop_testpmd().
+ *
+ * @param filter        Filter attached by test_attach_stream_tx_filter()
+ * @param n_streams     Maximum number of streams
+ * @param[out] tx       Packets transmitted by each stream
+ *
+ * @return The number of streams reported by testpmd.
+ */
+static unsigned int
+test_get_stream_tx_packets(tapi_job_channel_t *filter, unsigned int n_streams,
+                           unsigned long long *tx)
+{
+    tapi_job_buffer_t buf = TAPI_JOB_BUFFER_INIT;
+    unsigned int n_found = 0;
+
+    while (n_found < n_streams &&
+           tapi_job_receive(TAPI_JOB_CHANNEL_SET(filter),
+                            TEST_TESTPMD_STOP_TIMEOUT_MS, &buf) == 0 &&
+           !buf.eos)
+    {
+        tx[n_found++] = strtoull(buf.data.ptr, NULL, 10);
+        te_string_reset(&buf.data);
+    }
+
+    te_string_free(&buf.data);
+
+    return n_found;
+}
+
+/**
+ * Append testpmd commands building the shaped hierarchy.
+ *
+ * @param cmds          testpmd commands
+ * @param port_rate     Port shaper rate, Mbit/s, or @c 0
+ * @param queue_rate    Queue shaper rate, Mbit/s, or @c 0
+ * @param bucket_size   Token bucket size, bytes
+ * @param n_queues      The number of Tx queues
+ */
+static void
+test_append_tm_hierarchy(te_string *cmds, unsigned int port_rate,
+                         unsigned int queue_rate, unsigned int bucket_size,
+                         unsigned int n_queues)
+{
+    unsigned int i;
+
+    te_string_append(cmds, "port stop 0\n");
+
+    /* Shaper rates are specified in bytes per second */
+    if (port_rate != 0)
+    {
+        te_string_append(cmds,
+                         "add port tm node shaper profile 0 %d 0 0 %llu %u "
+                         "0 0\n", TEST_TM_PORT_SHAPER_ID,
+                         (unsigned long long)port_rate * 1000000 / 8,
+                         bucket_size);
+    }
+    if (queue_rate != 0)
+    {
+        te_string_append(cmds,
+                         "add port tm node shaper profile 0 %d 0 0 %llu %u "
+                         "0 0\n", TEST_TM_QUEUE_SHAPER_ID,
+                         (unsigned long long)queue_rate * 1000000 / 8,
+                         bucket_size);
+    }
+
+    te_string_append(cmds,
+                     "add port tm nonleaf node 0 %d %d 0 1 %d %d 1 0 0\n",
+                     TEST_TM_PORT_NODE_ID, TEST_TM_NONE, TEST_TM_LEVEL_PORT,
+                     port_rate != 0 ? TEST_TM_PORT_SHAPER_ID : TEST_TM_NONE);
+    te_string_append(cmds,
+                     "add port tm nonleaf node 0 %d %d 0 1 %d %d 1 0 0\n",
+                     TEST_TM_SUBPORT_NODE_ID, TEST_TM_PORT_NODE_ID,
+                     TEST_TM_LEVEL_SUBPORT, TEST_TM_NONE);
+
+    for (i = 0; i < n_queues; i++)
+    {
+        te_string_append(cmds,
+                         "add port tm leaf node 0 %u %d 0 1 %d %d 0 %d 0 0\n",
+                         i, TEST_TM_SUBPORT_NODE_ID, TEST_TM_LEVEL_QUEUE,
+                         queue_rate != 0 ? TEST_TM_QUEUE_SHAPER_ID :
+                                           TEST_TM_NONE,
+                         TEST_TM_NONE);
+    }
+
+    te_string_append(cmds, "port tm hierarchy commit 0 yes\n"
+                           "port start 0\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t testpmd_job_rx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    unsigned int packet_size;
+    unsigned int n_fwd_cores;
+    unsigned int testpmd_arg_txq;
+    unsigned int port_rate;
+    unsigned int queue_rate;
+    unsigned int bucket_size;
+    unsigned int max_deviation;
+    te_bool shaped;
+    unsigned long long shaped_rate = 0;
+    double expected_pps = 0;
+    double expected_queue_pps;
+    double achieved_pps = 0;
+    double queue_pps;
+
+    unsigned int n_iut_ports = 0;
+    unsigned int n_tst_ports = 0;
+    unsigned int iut_port_id = 0;
+    unsigned int tst_port = 0;
+    unsigned int iut_link_speed = 0;
+    unsigned int tst_link_speed = 0;
+    te_meas_stats_t meas_stats_tx = {0};
+    te_meas_stats_t meas_stats_rx = {0};
+    te_mi_logger *logger = NULL;
+
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    tapi_job_channel_t *stream_tx_filter = NULL;
+    double cycles[TEST_TM_N_RUNS] = {0};
+    unsigned long long *stream_tx = NULL;
+    unsigned long long total_tx = 0;
+    unsigned int n_streams = 0;
+    unsigned int n_runs;
+    unsigned int run;
+    unsigned int i;
+    te_string title = TE_STRING_INIT;
+
+    te_kvpair_h *rx_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_UINT_PARAM(testpmd_arg_txq);
+    TEST_GET_UINT_PARAM(n_fwd_cores);
+    TEST_GET_UINT_PARAM(port_rate);
+    TEST_GET_UINT_PARAM(queue_rate);
+    TEST_GET_UINT_PARAM(bucket_size);
+    TEST_GET_UINT_PARAM(max_deviation);
+    packet_size = TEST_UINT_PARAM(testpmd_command_txpkts);
+
+    test_check_mtu(iut_jobs_ctrl, iut_port, packet_size);
+
+    shaped = (port_rate != 0 || queue_rate != 0);
+    if (shaped)
+    {
+        /* Rates in Mbit/s */
+        if (queue_rate != 0)
+            shaped_rate = (unsigned long long)queue_rate * testpmd_arg_txq;
+        if (port_rate != 0)
+        {
+            shaped_rate = (shaped_rate == 0) ? port_rate :
+                          MIN(shaped_rate, port_rate);
+        }
+        /* Shapers do not account L1 overhead */
+        expected_pps = (double)shaped_rate * 1000000 / 8 / packet_size;
+    }
+    n_runs = shaped ? TEST_TM_N_RUNS : TEST_TM_RUN_UNSHAPED + 1;
+    stream_tx = tapi_calloc(testpmd_arg_txq, sizeof(*stream_tx));
+
+    TEST_STEP("Adjust testpmd parameters");
+    CHECK_RC(te_kvpair_add(&test_params, "testpmd_arg_rxq", "%s",
+                           TEST_STRING_PARAM(testpmd_arg_txq)));
+    /* This enables RSS that makes tester more likely to receive all traffic */
+    CHECK_RC(te_kvpair_add(&test_params, "testpmd_arg_txonly_multi_flow",
+                           "TRUE"));
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+
+    CHECK_RC(test_create_traffic_receiver_params(TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                             TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                             TEST_TESTPMD_RX_QUEUES_NUM,
+                                             packet_size, &rx_params));
+
+    TEST_STEP("Start traffic receiver on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env,
+                                          TEST_TESTPMD_RX_CPUS_NUM, &prop,
+                                          rx_params, &testpmd_job_rx));
+    CHECK_RC(tapi_dpdk_testpmd_start(&testpmd_job_rx));
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed_many_ports(&testpmd_job_rx, 1,
+                                                         &n_tst_ports,
+                                                         &tst_port,
+                                                         &tst_link_speed));
+
+    TEST_STEP("Measure unshaped Tx and, if a shaper is requested, shaped Tx");
+    for (run = 0; run < n_runs; run++)
+    {
+        TEST_SUBSTEP("Create testpmd job on IUT");
+        CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env,
+                                              n_fwd_cores, &prop,
+                                              &test_params, &testpmd_job));
+        if (cycles_supp)
+            CHECK_RC(test_attach_core_cycles_filter(&testpmd_job,
+                                                    &cycles_filter));
+        CHECK_RC(test_attach_stream_tx_filter(&testpmd_job,
+                                              &stream_tx_filter));
+
+        if (run == TEST_TM_RUN_SHAPED)
+        {
+            TEST_SUBSTEP("Build and commit port/subport/queue hierarchy "
+                         "with shapers on IUT port");
+            test_append_tm_hierarchy(&testpmd_job.cmdline_setup, port_rate,
+                                     queue_rate, bucket_size,
+                                     testpmd_arg_txq);
+        }
+
+        TEST_SUBSTEP("Start testpmd and retrieve link speed");
+        CHECK_RC(tapi_dpdk_testpmd_start(&testpmd_job));
+        CHECK_RC(tapi_dpdk_testpmd_get_link_speed_many_ports(&testpmd_job, 1,
+                                                             &n_iut_ports,
+                                                             &iut_port_id,
+                                                             &iut_link_speed));
+
+        if (shaped &&
+            expected_pps * (packet_size + TEST_ETH_L1_OVERHEAD) * 8 >
+            (double)iut_link_speed * 1000000)
+            TEST_SKIP("Shaped rate exceeds the link speed");
+
+        TEST_SUBSTEP("Retrieve TST Rx and IUT Tx stats");
+        CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_rx));
+        CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_tx));
+        CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&testpmd_job_rx, 1,
+                                                        &n_tst_ports,
+                                                        &tst_port, NULL,
+                                                        &meas_stats_rx));
+        CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&testpmd_job, 1,
+                                                        &n_iut_ports,
+                                                        &iut_port_id,
+                                                        &meas_stats_tx,
+                                                        NULL));
+
+        if (meas_stats_rx.data.mean == 0 || meas_stats_tx.data.mean == 0)
+            TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+        te_string_reset(&title);
+        te_string_append(&title, "%sTx", test_tm_run_names[run]);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_tx,
+                             packet_size, iut_link_speed,
+                             te_string_value(&title));
+        te_string_reset(&title);
+        te_string_append(&title, "%sRx", test_tm_run_names[run]);
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_rx,
+                             packet_size, tst_link_speed,
+                             te_string_value(&title));
+        achieved_pps = meas_stats_rx.data.mean;
+
+        TEST_SUBSTEP("Stop testpmd and get CPU cycles per packet and "
+                     "packets transmitted via each queue");
+        CHECK_RC(test_stop_testpmd(&testpmd_job));
+        if (cycles_supp)
+        {
+            CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter,
+                                                  &cycles[run]));
+            te_string_reset(&title);
+            te_string_append(&title, "%sCycles", test_tm_run_names[run]);
+            test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles[run],
+                                 te_string_value(&title));
+        }
+        n_streams = test_get_stream_tx_packets(stream_tx_filter,
+                                               testpmd_arg_txq, stream_tx);
+
+        tapi_dpdk_testpmd_destroy(&testpmd_job);
+        memset(&testpmd_job, 0, sizeof(testpmd_job));
+        te_meas_stats_free(&meas_stats_rx);
+        te_meas_stats_free(&meas_stats_tx);
+    }
+
+    if (!shaped)
+        TEST_SUCCESS;
+
+    TEST_STEP("Log shaped rates of port and queue nodes and CPU cost of "
+              "shaping");
+    /* Streams are not reported if there is one stream per port */
+    if (testpmd_arg_txq == 1 && n_streams == 0)
+    {
+        stream_tx[0] = 1;
+        n_streams = 1;
+    }
+    if (n_streams != testpmd_arg_txq)
+    {
+        TEST_VERDICT("Only %u of %u Tx queues transmitted packets",
+                     n_streams, testpmd_arg_txq);
+    }
+    for (i = 0; i < n_streams; i++)
+        total_tx += stream_tx[i];
+
+    CHECK_RC(te_mi_logger_meas_create(TAPI_DPDK_TESTPMD_NAME, &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "port_rate", "%u", port_rate);
+    te_mi_logger_add_meas_key(logger, NULL, "queue_rate", "%u", queue_rate);
+    te_mi_logger_add_meas_key(logger, NULL, "bucket_size", "%u", bucket_size);
+    te_mi_logger_add_comment(logger, NULL, "bucket_size_pkts", "%.1f",
+                             (double)bucket_size / packet_size);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "shaped",
+                          TE_MI_MEAS_AGGR_SINGLE, expected_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS, "port_node",
+                          TE_MI_MEAS_AGGR_MEAN, achieved_pps,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    for (i = 0; i < n_streams; i++)
+    {
+        te_string_reset(&title);
+        te_string_append(&title, "queue_node%u", i);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS,
+                              te_string_value(&title), TE_MI_MEAS_AGGR_MEAN,
+                              achieved_pps * stream_tx[i] / total_tx,
+                              TE_MI_MEAS_MULTIPLIER_PLAIN);
+    }
+    if (cycles_supp && cycles[TEST_TM_RUN_UNSHAPED] > 0)
+    {
+        te_mi_logger_add_comment(logger, NULL, "ShapingCyclesPenalty",
+                                 "%.2f%%", 100 *
+                                     (cycles[TEST_TM_RUN_SHAPED] /
+                                      cycles[TEST_TM_RUN_UNSHAPED] - 1));
+    }
+    te_mi_logger_destroy(logger);
+    logger = NULL;
+
+    RING("Shaped rate %llu Mbit/s gives %.0f pps, achieved %.0f pps",
+         shaped_rate, expected_pps, achieved_pps);
+
+    TEST_STEP("Check that the port rate is close to the shaped one and "
+              "no queue exceeds its shaper");
+    if (achieved_pps * 100 > expected_pps * (100 + max_deviation))
+        TEST_VERDICT("Achieved rate exceeds the shaped one");
+    if (achieved_pps * 100 < expected_pps * (100 - max_deviation))
+        TEST_VERDICT("Achieved rate is below the shaped one");
+
+    if (queue_rate != 0)
+    {
+        expected_queue_pps = (double)queue_rate * 1000000 / 8 / packet_size;
+        for (i = 0; i < n_streams; i++)
+        {
+            queue_pps = achieved_pps * stream_tx[i] / total_tx;
+            if (queue_pps * 100 > expected_queue_pps * (100 + max_deviation))
+                TEST_VERDICT("Queue rate exceeds the queue shaper one");
+        }
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    te_mi_logger_destroy(logger);
+    tapi_dpdk_testpmd_destroy(&testpmd_job);
+    tapi_dpdk_testpmd_destroy(&testpmd_job_rx);
+    te_meas_stats_free(&meas_stats_tx);
+    te_meas_stats_free(&meas_stats_rx);
+    te_kvpair_fini(rx_params);
+    te_string_free(&title);
+    free(stream_tx);
+
+    TEST_END;
+}
+/** @} */
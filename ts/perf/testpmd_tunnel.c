@@ -0,0 +1,297 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Performance Test Suite
+ */
+
+/** @defgroup perf-testpmd_tunnel Test tunnel encap/decap offload performance
+ * @ingroup perf
+ * @{
+ *
+ * @objective Test forwarding performance of dpdk-testpmd when tunnel
+ *            encapsulation or decapsulation is offloaded using flow rules
+ *            and compare it with plain IO forwarding
+ *
+ * @param generator_mode    Traffic generator mode
+ * @param packet_size       Inner packet size without FCS
+ * @param n_cores           The number of IUT testpmd cores
+ * @param tunnel_type       Tunnel type (@c vxlan or @c geneve)
+ * @param offload           Offload to use:
+ *                          - @c none Plain IO forwarding
+ *                          - @c encap Encapsulate forwarded packets using
+ *                            egress flow rule with RAW_ENCAP action
+ *                          - @c decap Decapsulate received packets using
+ *                            ingress flow rule with RAW_DECAP action
+ *                          - @c tunnel_offload Decapsulate received packets
+ *                            using flow tunnel offload API rules
+ *                            (TUNNEL_SET and TUNNEL_MATCH)
+ *
+ * @type performance
+ *
+ * Traffic is returned to the traffic generator on the same port. If
+ * decapsulation is tested, the traffic generator encapsulates packets
+ * using egress flow rule, so TST NIC must support it. Decapsulated
+ * packets are spread over all Rx queues by RSS action with default
+ * parameters, so all @p n_cores forwarding cores are used.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME "perf/testpmd_tunnel"
+
+#include "dpdk_pmd_test.h"
+#include "tapi_job.h"
+#include "tapi_cfg_cpu.h"
+#include "tapi_dpdk.h"
+#include "tapi_dpdk_stats.h"
+#include "dpdk_pmd_test_perf.h"
+
+#define TEST_TESTPMD_TX_GENERATOR_TXD 512U
+#define TEST_TESTPMD_TX_GENERATOR_BURST 128U
+#define TEST_TESTPMD_TX_GENERATOR_TXFREET 0U
+
+/**
+ * Outer headers length: Ethernet, IPv4, UDP and VXLAN or GENEVE
+ * without options.
+ */
+#define TEST_TUNNEL_OVERHEAD 50U
+
+/** Flow tunnel ID assigned by testpmd to the first created tunnel */
+#define TEST_FLOW_TUNNEL_ID 1
+
+#define TEST_OUTER_SRC_MAC "00:00:5e:00:03:03"
+#define TEST_OUTER_SRC_IP "198.18.0.1"
+#define TEST_OUTER_DST_IP "198.18.0.2"
+#define TEST_TUNNEL_VNI 100
+
+/** Testpmd flow pattern items matching the tunnel header */
+static const char *
+test_tunnel_items(const char *tunnel_type)
+{
+    if (strcmp(tunnel_type, "vxlan") == 0)
+        return "udp dst is 4789 / vxlan";
+
+    return "udp dst is 6081 / geneve";
+}
+
+/** Append testpmd command setting outer headers to be used by RAW_ENCAP */
+static void
+test_append_raw_encap(te_string *cmds, const char *tunnel_type,
+                      const char *dst_mac)
+{
+    te_string_append(cmds,
+                     "set raw_encap 0 eth src is " TEST_OUTER_SRC_MAC
+                     " dst is %s type is 0x0800 / ipv4 src is "
+                     TEST_OUTER_SRC_IP " dst is " TEST_OUTER_DST_IP
+                     " ttl is 64 / %s vni is %d / end_set\n",
+                     dst_mac, test_tunnel_items(tunnel_type),
+                     TEST_TUNNEL_VNI);
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server *iut_jobs_ctrl = NULL;
+    rcf_rpc_server *tst_jobs_ctrl = NULL;
+    const struct if_nameindex *iut_port = NULL;
+
+    tapi_dpdk_testpmd_job_t iut_testpmd_job = {0};
+    tapi_dpdk_testpmd_job_t tst_testpmd_job = {0};
+
+    unsigned int tst_link_speed = 0;
+    te_meas_stats_t tst_stats_rx = {0};
+    te_meas_stats_t tst_stats_tx = {0};
+
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+
+    const char *generator_mode;
+    const char *tunnel_type;
+    const char *offload;
+    unsigned int n_cores;
+    unsigned int n_tst_cores;
+    unsigned int packet_size;
+    unsigned int tx_packet_size;
+    unsigned int rx_packet_size;
+    unsigned int mbuf_size;
+    unsigned int mtu;
+    te_bool encap;
+    te_bool decap;
+    const char *txpkts;
+    char *iut_mac = NULL;
+
+    te_kvpair_h *traffic_generator_params = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_PCO(tst_jobs_ctrl);
+    TEST_GET_IF(iut_port);
+    TEST_GET_STRING_PARAM(generator_mode);
+    TEST_GET_UINT_PARAM(n_cores);
+    TEST_GET_UINT_PARAM(packet_size);
+    TEST_GET_STRING_PARAM(tunnel_type);
+    TEST_GET_STRING_PARAM(offload);
+    txpkts = TEST_STRING_PARAM(packet_size);
+
+    encap = (strcmp(offload, "encap") == 0);
+    decap = (strcmp(offload, "decap") == 0 ||
+             strcmp(offload, "tunnel_offload") == 0);
+
+    if (strcmp(offload, "tunnel_offload") == 0 &&
+        strcmp(tunnel_type, "vxlan") != 0)
+        TEST_SKIP("Flow tunnel offload supports VXLAN only");
+
+    tx_packet_size = packet_size + (decap ? TEST_TUNNEL_OVERHEAD : 0);
+    rx_packet_size = packet_size + (encap ? TEST_TUNNEL_OVERHEAD : 0);
+
+    test_check_mtu(iut_jobs_ctrl, iut_port,
+                   packet_size + TEST_TUNNEL_OVERHEAD);
+
+    CHECK_RC(test_create_traffic_generator_params(tst_jobs_ctrl->ta,
+                                    TAPI_DPDK_TESTPMD_ARG_PREFIX,
+                                    TAPI_DPDK_TESTPMD_COMMAND_PREFIX,
+                                    generator_mode, txpkts, FALSE, 0,
+                                    TEST_TESTPMD_TX_GENERATOR_TXD,
+                                    TEST_TESTPMD_TX_GENERATOR_BURST,
+                                    TEST_TESTPMD_TX_GENERATOR_TXFREET,
+                                    &traffic_generator_params,
+                                    &n_tst_cores));
+
+    CHECK_RC(cfg_get_string(&iut_mac, "/local:/dpdk:/mac:%s%u",
+                            TEST_ENV_IUT_PORT, 0));
+    CHECK_RC(te_kvpair_add(traffic_generator_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "eth_peer",
+                           "0,%s", iut_mac));
+
+    TEST_STEP("Set MTU and mbuf size on both sides to fit encapsulated "
+              "packets");
+    if (tapi_dpdk_mtu_by_pkt_size(packet_size + TEST_TUNNEL_OVERHEAD, &mtu))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+        CHECK_RC(te_kvpair_add(traffic_generator_params,
+                               TAPI_DPDK_TESTPMD_COMMAND_PREFIX "mtu",
+                               "%u", mtu));
+    }
+    if (tapi_dpdk_mbuf_size_by_pkt_size(packet_size + TEST_TUNNEL_OVERHEAD,
+                                        &mbuf_size))
+    {
+        CHECK_RC(te_kvpair_add(&test_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+        CHECK_RC(te_kvpair_add(traffic_generator_params,
+                               TAPI_DPDK_TESTPMD_ARG_PREFIX "mbuf_size",
+                               "%u", mbuf_size));
+    }
+
+    TEST_STEP("Adjust testpmd parameters to return traffic to the port "
+              "it is received on");
+    CHECK_RC(te_kvpair_add(&test_params,
+                           TAPI_DPDK_TESTPMD_ARG_PREFIX "port_topology",
+                           "loop"));
+
+    TEST_STEP("Create testpmd job to forward traffic on IUT");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(iut_jobs_ctrl, &env, n_cores,
+                                          &prop, &test_params,
+                                          &iut_testpmd_job));
+
+    if (encap)
+    {
+        TEST_STEP("If @p offload is @c encap, add egress flow rule to "
+                  "encapsulate all forwarded packets");
+        test_append_raw_encap(&iut_testpmd_job.cmdline_setup, tunnel_type,
+                              "ff:ff:ff:ff:ff:ff");
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 egress pattern eth / end "
+                         "actions raw_encap index 0 / end\n");
+    }
+    else if (strcmp(offload, "decap") == 0)
+    {
+        TEST_STEP("If @p offload is @c decap, add ingress flow rule to "
+                  "decapsulate all received tunnel packets");
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "set raw_decap 0 eth / ipv4 / %s / end_set\n",
+                         test_tunnel_items(tunnel_type));
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 ingress pattern eth / ipv4 / %s / "
+                         "end actions raw_decap index 0 / rss / end\n",
+                         test_tunnel_items(tunnel_type));
+    }
+    else if (decap)
+    {
+        TEST_STEP("If @p offload is @c tunnel_offload, create flow tunnel "
+                  "and add TUNNEL_SET and TUNNEL_MATCH rules to decapsulate "
+                  "all received tunnel packets");
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow tunnel create 0 type %s\n", tunnel_type);
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 ingress group 0 tunnel_set %d "
+                         "pattern eth / ipv4 / %s / end "
+                         "actions jump group 1 / end\n",
+                         TEST_FLOW_TUNNEL_ID,
+                         test_tunnel_items(tunnel_type));
+        te_string_append(&iut_testpmd_job.cmdline_setup,
+                         "flow create 0 ingress group 1 tunnel_match %d "
+                         "pattern eth / ipv4 / %s / eth / end "
+                         "actions rss / end\n",
+                         TEST_FLOW_TUNNEL_ID,
+                         test_tunnel_items(tunnel_type));
+    }
+
+    TEST_STEP("Create testpmd job to run traffic generator on TST");
+    CHECK_RC(tapi_dpdk_create_testpmd_job(tst_jobs_ctrl, &env, n_tst_cores,
+                                          &prop, traffic_generator_params,
+                                          &tst_testpmd_job));
+
+    if (decap)
+    {
+        TEST_STEP("If packets are decapsulated on IUT, add egress flow rule "
+                  "to encapsulate generated packets on TST");
+        test_append_raw_encap(&tst_testpmd_job.cmdline_setup, tunnel_type,
+                              iut_mac);
+        te_string_append(&tst_testpmd_job.cmdline_setup,
+                         "flow create 0 egress pattern eth / end "
+                         "actions raw_encap index 0 / end\n");
+    }
+
+    TEST_STEP("Start the jobs");
+    CHECK_RC(tapi_dpdk_testpmd_start(&iut_testpmd_job));
+    CHECK_RC(tapi_dpdk_testpmd_start(&tst_testpmd_job));
+
+    TEST_STEP("Retrieve link speed from running traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_link_speed(&tst_testpmd_job,
+                                              &tst_link_speed));
+
+    TEST_STEP("Initialize TST Rx and Tx statistics");
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_rx));
+    CHECK_RC(test_meas_stats_init(&test_params, &tst_stats_tx));
+
+    TEST_STEP("Retrieve Tx and returned Rx stats from traffic generator");
+    CHECK_RC(tapi_dpdk_testpmd_get_stats(&tst_testpmd_job, &tst_stats_tx,
+                                         &tst_stats_rx));
+
+    TEST_STEP("Check and log measurement results taking into account "
+              "that packets are longer on the wire when encapsulated");
+    if (tst_stats_rx.data.mean == 0 || tst_stats_tx.data.mean == 0)
+        TEST_VERDICT("Failure: zero Tx or Rx packets per second");
+
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_tx,
+                         tx_packet_size, tst_link_speed, "Tx");
+    test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &tst_stats_rx,
+                         rx_packet_size, tst_link_speed,
+                         encap ? "EncapRx" :
+                         decap ? "DecapRx" : "FwdRx");
+
+    TEST_SUCCESS;
+
+cleanup:
+    tapi_dpdk_testpmd_destroy(&tst_testpmd_job);
+    tapi_dpdk_testpmd_destroy(&iut_testpmd_job);
+    te_kvpair_fini(traffic_generator_params);
+    te_meas_stats_free(&tst_stats_rx);
+    te_meas_stats_free(&tst_stats_tx);
+    free(iut_mac);
+
+    TEST_END;
+}
+/** @} */
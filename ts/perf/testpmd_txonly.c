@@ -10,6 +10,8 @@
  *
  * @objective Test dpdk-testpmd performance in Tx only mode
  *
+ * @param mbuf_fast_free    Enable MBUF_FAST_FREE Tx offload if @c TRUE
+ *                          (optional, disabled by default)
  *
  * @type performance
  *
@@ -54,6 +56,7 @@ main(int argc, char *argv[])
     int txpkts_len;
     unsigned int testpmd_arg_txonly_tso_mss;
     te_bool tso_requested;
+    te_bool mbuf_fast_free = FALSE;
     unsigned long rx_pkts;
     unsigned long rx_bytes;
     size_t idx;
@@ -72,10 +75,25 @@ main(int argc, char *argv[])
     te_kvpair_h *rx_params = NULL;
     te_string str = TE_STRING_INIT;
 
+    te_bool cycles_supp;
+    tapi_job_channel_t *cycles_filter = NULL;
+    double cycles;
+
+    te_bool bursts_supp;
+    tapi_job_channel_t *tx_bursts_filter = NULL;
+
+    test_perf_stat perf_stat;
+    test_perf_record perf_record;
+    double tx_pps = 0;
+    double deficit;
+
     te_bool dbells_supp;
     te_kvpair_h dbells_opt;
     te_kvpair_init(&dbells_opt);
 
+    test_perf_stat_init(&perf_stat);
+    test_perf_record_init(&perf_record);
+
     TEST_START;
     TEST_GET_PCO(iut_jobs_ctrl);
     TEST_GET_PCO(tst_jobs_ctrl);
@@ -83,6 +101,8 @@ main(int argc, char *argv[])
 
     n_fwd_cores = TEST_UINT_PARAM(n_fwd_cores);
     TEST_GET_UINT_PARAM(testpmd_arg_txq);
+    if (TEST_HAS_PARAM(mbuf_fast_free))
+        TEST_GET_BOOL_PARAM(mbuf_fast_free);
 
     for (idx = 0; idx < TE_ARRAY_LEN(iut_ifs); ++idx, ++n_ports)
     {
@@ -115,6 +135,19 @@ main(int argc, char *argv[])
             tx_offloads |= UINT64_C(1) << 15;
         }
 
+        if (mbuf_fast_free)
+        {
+            if (!test_conf_tx_offload_supported(iut_jobs_ctrl, iut_ifs[idx],
+                    TARPC_RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE_BIT))
+                TEST_SKIP("MBUF_FAST_FREE is not supported");
+            /*
+             * Enable MBUF_FAST_FREE Tx offload.
+             * TODO avoid hardcodes: RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE is
+             * RTE_BIT64(16)
+             */
+            tx_offloads |= UINT64_C(1) << 16;
+        }
+
         tso_requested = TEST_HAS_PARAM(testpmd_arg_txonly_tso_mss);
         if (tso_requested)
         {
@@ -174,6 +207,11 @@ main(int argc, char *argv[])
                                         TEST_STRING_PARAM(testpmd_arg_txq)));
     }
 
+    CHECK_RC(test_add_record_core_cycles(iut_jobs_ctrl, &env, &test_params,
+                                         &cycles_supp));
+    CHECK_RC(test_add_record_burst_stats(iut_jobs_ctrl, &env, &test_params,
+                                         &bursts_supp));
+
     if (tso_requested)
     {
         te_bool tso_mss_supp;
@@ -219,6 +257,23 @@ main(int argc, char *argv[])
         CHECK_RC(tapi_dpdk_attach_rx_pkts_bytes_filters(&testpmd_job_rx));
     }
 
+    if (cycles_supp)
+    {
+        TEST_STEP("Attach CPU cycles filter");
+        CHECK_RC(test_attach_core_cycles_filter(&testpmd_job,
+                                                &cycles_filter));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Attach burst stats filters");
+        CHECK_RC(test_attach_burst_stats_filter(&testpmd_job, FALSE,
+                                                &tx_bursts_filter));
+    }
+
+    CHECK_RC(test_perf_stat_attach(&perf_stat, testpmd_job.out_chs[0]));
+    CHECK_RC(test_perf_record_attach(&perf_record, testpmd_job.out_chs[0]));
+
     CHECK_RC(tapi_dpdk_testpmd_start(&testpmd_job_rx));
     CHECK_RC(tapi_dpdk_testpmd_start(&testpmd_job));
 
@@ -234,11 +289,16 @@ main(int argc, char *argv[])
                                                          tst_ports,
                                                          tst_link_speed));
 
+    TEST_STEP("Start hardware performance counters collection and "
+              "profiling on IUT forwarding cores if requested");
+    test_perf_stat_start(&perf_stat, iut_jobs_ctrl);
+    test_perf_record_start(&perf_record, iut_jobs_ctrl);
+
     TEST_STEP("Initialize TST Rx and IUT Tx statistics");
     for (port = 0; port < n_ports; ++port)
     {
-        CHECK_RC(test_meas_stats_init(&meas_stats_rx[port]));
-        CHECK_RC(test_meas_stats_init(&meas_stats_tx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_rx[port]));
+        CHECK_RC(test_meas_stats_init(&test_params, &meas_stats_tx[port]));
     }
 
     TEST_STEP("Retrieve Rx stats from running testpmd");
@@ -247,9 +307,11 @@ main(int argc, char *argv[])
                                                     NULL, meas_stats_rx));
 
     TEST_STEP("Retrieve Tx stats from running testpmd");
-    CHECK_RC(tapi_dpdk_testpmd_get_stats_many_ports(&testpmd_job, n_ports,
-                                                    &n_iut_ports, iut_ports,
-                                                    meas_stats_tx, NULL));
+    CHECK_RC(test_testpmd_get_stats_many_ports(iut_jobs_ctrl, &test_params,
+                                               &testpmd_job,
+                                               n_ports, &n_iut_ports,
+                                               iut_ports, meas_stats_tx,
+                                               NULL));
 
     if (tso_requested)
     {
@@ -267,21 +329,23 @@ main(int argc, char *argv[])
             meas_stats_tx[port].data.mean == 0)
             TEST_VERDICT("Failure: zero Tx or Rx packets per second");
 
+        tx_pps += meas_stats_tx[port].data.mean;
+
         te_string_reset(&str);
         te_string_append(&str, "Tx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_tx[port],
-                                  packet_size, iut_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_tx[port],
+                             packet_size, iut_link_speed[port],
+                             te_string_value(&str));
 
         te_string_reset(&str);
         te_string_append(&str, "Rx");
         if (n_ports > 1)
             te_string_append(&str, "%u", port);
-        tapi_dpdk_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_rx[port],
-                                  packet_size, tst_link_speed[port],
-                                  te_string_value(&str));
+        test_stats_log_rates(TAPI_DPDK_TESTPMD_NAME, &meas_stats_rx[port],
+                             packet_size, tst_link_speed[port],
+                             te_string_value(&str));
 
         if (dbells_supp)
             CHECK_RC(tapi_dpdk_stats_log_tx_dbells(&testpmd_job, &meas_stats_tx[port]));
@@ -294,9 +358,39 @@ main(int argc, char *argv[])
                                        iut_link_speed, "Tx");
     }
 
+    test_perf_stat_log(&perf_stat, TAPI_DPDK_TESTPMD_NAME, tx_pps, "Tx");
+    test_perf_record_save(&perf_record, iut_jobs_ctrl, "Tx");
+
+    if (cycles_supp || bursts_supp)
+    {
+        TEST_STEP("Stop IUT testpmd to get its forwarding statistics");
+        CHECK_RC(test_stop_testpmd(&testpmd_job));
+    }
+
+    if (bursts_supp)
+    {
+        TEST_STEP("Log burst sizes distribution");
+        CHECK_RC(test_log_burst_stats(TAPI_DPDK_TESTPMD_NAME,
+                                      tx_bursts_filter, "TxBursts"));
+    }
+
+    if (cycles_supp)
+    {
+        TEST_STEP("Log CPU cycles per packet");
+        CHECK_RC(test_get_core_cycles_per_pkt(cycles_filter, &cycles));
+        test_log_core_cycles(TAPI_DPDK_TESTPMD_NAME, cycles, "TxCycles");
+    }
+
+    TEST_STEP("Compare the rate with performance baseline");
+    if (test_perf_below_baseline(TE_TEST_NAME, packet_size, n_fwd_cores, tx_pps,
+                                 &deficit))
+        TEST_VERDICT("Throughput below baseline by %.0f%%", deficit);
+
     TEST_SUCCESS;
 
 cleanup:
+    test_perf_stat_fini(&perf_stat);
+    test_perf_record_fini(&perf_record);
     tapi_dpdk_testpmd_destroy(&testpmd_job);
     tapi_dpdk_testpmd_destroy(&testpmd_job_rx);
     for (port = 0; port < n_ports; ++port)
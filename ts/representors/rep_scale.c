@@ -0,0 +1,373 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK Port Representors Test Suite
+ * Port representors use cases
+ */
+
+/** @defgroup representors-rep_scale Port representors scalability
+ * @ingroup representors
+ * @{
+ *
+ * @objective Check how hotplug time, start time, memory consumption and
+ *            forwarding rate through a representor depend on the number
+ *            of port representors
+ *
+ * @param max_slowdown      Maximum allowed decrease of the forwarding rate
+ *                          through a representor with many representors
+ *                          compared to a single representor, percents
+ *
+ * @type representor
+ *
+ * The number of representors is doubled on each step until all VFs
+ * of the PF are represented. Memory consumption is reported separately
+ * for huge pages (DPDK heap) and for resident memory of the RPC server
+ * process (libc heap and other non-huge page memory).
+ *
+ * Forwarding rate is measured by dpdk-testpmd which plugs the same number
+ * of representors after the RPC server releases the devices. testpmd
+ * forwards packets in IO mode between the first representor and its VF,
+ * so packets injected on start circulate between them in a loop and
+ * the representor Tx rate is read from DPDK telemetry socket.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME  "representors/rep_scale"
+
+#include <sys/time.h>
+
+#include "dpdk_pmd_test.h"
+#include "tapi_file.h"
+#include "tapi_cfg_pci.h"
+#include "tapi_rpc_unistd.h"
+#include "tapi_dpdk.h"
+#include "te_mi_log.h"
+#include "dpdk_pmd_test_perf.h"
+
+/** The number of mbufs in the mempool per port */
+#define TEST_MBUFS_PER_PORT 1024
+
+/** The number of testpmd forwarding cores */
+#define TEST_FWD_CORES 1
+
+/** Interval of representor statistics sampling from telemetry socket */
+#define TEST_FWD_STATS_INTERVAL_MS 1000
+
+/**
+ * Get the amount of memory in free huge pages on the agent.
+ *
+ * @param ta        Test agent name
+ * @param free_kb   Location for free memory, kilobytes
+ */
+static void
+test_get_free_hugepages_kb(const char *ta, unsigned long long *free_kb)
+{
+    unsigned long long nb_free = 0;
+    unsigned long long page_kb = 0;
+    char *meminfo = NULL;
+    char *line;
+
+    CHECK_RC(tapi_file_read_ta(ta, "/proc/meminfo", &meminfo));
+
+    for (line = meminfo; line != NULL && *line != '\0';
+         line = strchr(line, '\n'), line = (line == NULL) ? NULL : line + 1)
+    {
+        if (strncmp(line, "HugePages_Free:", strlen("HugePages_Free:")) == 0)
+            nb_free = strtoull(line + strlen("HugePages_Free:"), NULL, 10);
+        else if (strncmp(line, "Hugepagesize:", strlen("Hugepagesize:")) == 0)
+            page_kb = strtoull(line + strlen("Hugepagesize:"), NULL, 10);
+    }
+
+    free(meminfo);
+
+    *free_kb = nb_free * page_kb;
+}
+
+/**
+ * Get resident memory size of the RPC server process. Huge pages are
+ * not accounted in it.
+ *
+ * @param rpcs      RPC server
+ * @param rss_kb    Location for resident memory size, kilobytes
+ */
+static void
+test_get_rpcs_rss_kb(rcf_rpc_server *rpcs, unsigned long long *rss_kb)
+{
+    te_string path = TE_STRING_INIT;
+    char *status = NULL;
+    char *line;
+
+    te_string_append(&path, "/proc/%d/status", (int)rpc_getpid(rpcs));
+    CHECK_RC(tapi_file_read_ta(rpcs->ta, path.ptr, &status));
+
+    line = strstr(status, "VmRSS:");
+    if (line == NULL)
+        TEST_FAIL("Cannot find VmRSS in %s", path.ptr);
+
+    *rss_kb = strtoull(line + strlen("VmRSS:"), NULL, 10);
+
+    free(status);
+    te_string_free(&path);
+}
+
+/**
+ * Measure forwarding rate through the first representor when the given
+ * number of representors is plugged by testpmd.
+ *
+ * @param rpcs      RPC server to run testpmd on
+ * @param pf_addr   PCI address of the PF
+ * @param vf_addr   PCI address of the first VF
+ * @param n_reps    The number of representors to plug
+ * @param vf_ids    IDs of VFs to plug representors of, the first one
+ *                  is used for forwarding
+ * @param rate      Location for the representor Tx rate, packets per second
+ */
+static void
+test_measure_rep_fwd_rate(rcf_rpc_server *rpcs, const char *pf_addr,
+                          const char *vf_addr, unsigned int n_reps,
+                          const unsigned int *vf_ids, double *rate)
+{
+    tapi_dpdk_testpmd_job_t job = {0};
+    tapi_cpu_prop_t prop = { .isolated = TRUE };
+    te_meas_stats_t stats_tx = {0};
+    te_string rep_ids = TE_STRING_INIT;
+    char *pf_dev_args = NULL;
+    char *vf_dev_args = NULL;
+    /* The PF is port 0, representors follow it, then the VF is attached */
+    unsigned int rep_port = 1;
+    unsigned int vf_port = n_reps + 1;
+    unsigned int i;
+
+    for (i = 0; i < n_reps; i++)
+        te_string_append(&rep_ids, "%s%u", i == 0 ? "" : ",", vf_ids[i]);
+
+    CHECK_RC(tapi_rte_get_dev_args_by_pci_addr(rpcs->ta, pf_addr,
+                                               &pf_dev_args));
+    CHECK_RC(tapi_rte_get_dev_args_by_pci_addr(rpcs->ta, vf_addr,
+                                               &vf_dev_args));
+
+    CHECK_RC(tapi_dpdk_create_testpmd_job(rpcs, &env, TEST_FWD_CORES, &prop,
+                                          &test_params, &job));
+    te_string_append(&job.cmdline_setup,
+                     "port attach %s,%s%srepresentor=[%s]\n"
+                     "port attach %s%s%s\n"
+                     "port start all\n"
+                     "set portlist %u,%u\n", pf_addr,
+                     pf_dev_args == NULL ? "" : pf_dev_args,
+                     pf_dev_args == NULL ? "" : ",", rep_ids.ptr,
+                     vf_addr, vf_dev_args == NULL ? "" : ",",
+                     vf_dev_args == NULL ? "" : vf_dev_args,
+                     rep_port, vf_port);
+
+    CHECK_RC(tapi_dpdk_testpmd_start(&job));
+
+    CHECK_RC(test_meas_stats_init(&test_params, &stats_tx));
+    CHECK_RC(test_telemetry_get_stats_ports(rpcs, "testpmd",
+                                            TEST_FWD_STATS_INTERVAL_MS, 1,
+                                            &rep_port, &stats_tx, NULL));
+    *rate = stats_tx.data.mean;
+
+    tapi_dpdk_testpmd_destroy(&job);
+    te_meas_stats_free(&stats_tx);
+    te_string_free(&rep_ids);
+    free(pf_dev_args);
+    free(vf_dev_args);
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server                         *iut_rpcs = NULL;
+    rcf_rpc_server                         *iut_jobs_ctrl = NULL;
+    const tapi_env_if                      *iut_port = NULL;
+    struct test_ethdev_config               ethdev_config;
+    struct test_ethdev_config              *ethdev_config_reps = NULL;
+    rpc_rte_mempool_p                       mp;
+    unsigned int                            max_slowdown;
+
+    unsigned int                            n_vfs = 0;
+    char                                  **vf_addrs = NULL;
+    unsigned int                           *vf_ids = NULL;
+    unsigned int                            n_reps = 0;
+    unsigned int                            n;
+    unsigned int                            i;
+    unsigned long long                      free_kb_init;
+    unsigned long long                      free_kb;
+    unsigned long long                      rss_kb_init;
+    unsigned long long                      rss_kb;
+    double                                  fwd_pps;
+    double                                  fwd_pps_single = 0;
+    char                                   *vf_oid = NULL;
+    char                                   *vf_driver = NULL;
+
+    TEST_START;
+    TEST_GET_PCO(iut_rpcs);
+    TEST_GET_PCO(iut_jobs_ctrl);
+    TEST_GET_ENV_IF(iut_port);
+    TEST_GET_UINT_PARAM(max_slowdown);
+
+    test_prepare_config_def_mk(&env, iut_rpcs, &iut_port->if_info,
+                               &ethdev_config);
+
+    TEST_STEP("Get all VFs of the PF");
+    test_get_vf_pci_addrs_by_node(tapi_env_get_if_net_node(iut_port),
+                                  &n_vfs, &vf_addrs, &vf_ids);
+    if (n_vfs == 0)
+        TEST_SKIP("The PF has no VFs");
+
+    TEST_STEP("Create a mempool big enough for PF and all representors");
+    mp = test_rte_pktmbuf_pool_create(iut_rpcs, TEST_PKTS_MEMPOOL_NAME,
+                                     (n_vfs + 1) * TEST_MBUFS_PER_PORT,
+                                     TEST_RTE_MEMPOOL_DEF_CACHE,
+                                     TEST_RTE_MEMPOOL_DEF_PRIV_SIZE,
+                                     TEST_RTE_MEMPOOL_DEF_DATA_ROOM,
+                                     rpc_rte_eth_dev_socket_id(iut_rpcs,
+                                            iut_port->if_info.if_index));
+
+    TEST_STEP("Start the PF");
+    ethdev_config.mp = mp;
+    CHECK_RC(test_prepare_ethdev(&ethdev_config, TEST_ETHDEV_STARTED));
+
+    TEST_STEP("Remember the amount of free huge pages memory and "
+              "resident memory of the RPC server");
+    test_get_free_hugepages_kb(iut_rpcs->ta, &free_kb_init);
+    test_get_rpcs_rss_kb(iut_rpcs, &rss_kb_init);
+
+    TEST_STEP("Double the number of representors starting from 1 until "
+              "all VFs are represented");
+    for (n = 1; n != 0; n = (n == n_vfs) ? 0 : MIN(n * 2, n_vfs))
+    {
+        struct timeval  tv_start;
+        struct timeval  tv_end;
+        long long       hotplug_us;
+        long long       start_us = 0;
+        long long       hugepages_kb;
+        long long       rss_grow_kb;
+        te_mi_logger   *logger;
+        int             st;
+
+        TEST_SUBSTEP("Close representors added on the previous step");
+        for (i = 0; i < n_reps; i++)
+        {
+            CHECK_RC(test_prepare_ethdev(&ethdev_config_reps[i],
+                                         TEST_ETHDEV_CLOSED));
+        }
+        free(ethdev_config_reps);
+        ethdev_config_reps = NULL;
+        n_reps = 0;
+
+        TEST_SUBSTEP("Hotplug representors of the first VFs");
+        gettimeofday(&tv_start, NULL);
+        test_hotplug_reps(iut_rpcs, &env, tapi_env_get_if_net_node(iut_port),
+                          n, vf_ids, &ethdev_config_reps);
+        gettimeofday(&tv_end, NULL);
+        hotplug_us = TIMEVAL_SUB(tv_end, tv_start);
+        n_reps = n;
+
+        TEST_SUBSTEP("Start all representors");
+        for (i = 0; i < n_reps; i++)
+        {
+            ethdev_config_reps[i].mp = mp;
+            CHECK_RC(test_prepare_ethdev(&ethdev_config_reps[i],
+                                         TEST_ETHDEV_STARTED));
+
+            for (st = TEST_ETHDEV_CONFIGURED; st <= TEST_ETHDEV_STARTED; st++)
+                start_us += ethdev_config_reps[i].transition_us[st];
+        }
+
+        TEST_SUBSTEP("Get huge pages and resident memory consumption");
+        test_get_free_hugepages_kb(iut_rpcs->ta, &free_kb);
+        test_get_rpcs_rss_kb(iut_rpcs, &rss_kb);
+        /* Free memory may grow if somebody else releases it */
+        hugepages_kb = (long long)free_kb_init - (long long)free_kb;
+        rss_grow_kb = (long long)rss_kb - (long long)rss_kb_init;
+
+        RING("%u representors: hotplug %lld us per representor, "
+             "start %lld us in total, %lld kB of huge pages used, "
+             "RPC server resident memory grown by %lld kB",
+             n, hotplug_us / n, start_us, hugepages_kb, rss_grow_kb);
+
+        CHECK_RC(te_mi_logger_meas_create("dpdk", &logger));
+        te_mi_logger_add_meas_key(logger, NULL, "representors", "%u", n);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY,
+                              "hotplug_per_representor",
+                              TE_MI_MEAS_AGGR_SINGLE,
+                              (double)hotplug_us / n,
+                              TE_MI_MEAS_MULTIPLIER_MICRO);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY,
+                              "start_all", TE_MI_MEAS_AGGR_SINGLE,
+                              start_us, TE_MI_MEAS_MULTIPLIER_MICRO);
+        te_mi_logger_add_comment(logger, NULL, "hugepages_used_kb", "%lld",
+                                 hugepages_kb);
+        te_mi_logger_add_comment(logger, NULL, "rss_grown_kb", "%lld",
+                                 rss_grow_kb);
+        te_mi_logger_destroy(logger);
+    }
+
+    TEST_STEP("Restart IUT RPC server to release the devices for testpmd");
+    CHECK_RC(rcf_rpc_server_restart(iut_rpcs));
+    /* RPC server must have enough time to die */
+    SLEEP(1);
+
+    TEST_STEP("Bind the first VF to DPDK driver to forward traffic "
+              "through its representor");
+    CHECK_RC(tapi_cfg_pci_oid_by_addr(iut_jobs_ctrl->ta, vf_addrs[0],
+                                      &vf_oid));
+    CHECK_RC(tapi_cfg_pci_get_driver(vf_oid, &vf_driver));
+    CHECK_RC_VERDICT(tapi_cfg_pci_bind_ta_driver_on_device(iut_jobs_ctrl->ta,
+                                                           NET_DRIVER_TYPE_DPDK,
+                                                           vf_addrs[0]),
+                     "Failed to bind VF to DPDK driver");
+
+    TEST_STEP("Double the number of representors plugged by testpmd in "
+              "the same way and measure forwarding rate through the first "
+              "representor");
+    for (n = 1; n != 0; n = (n == n_vfs) ? 0 : MIN(n * 2, n_vfs))
+    {
+        te_mi_logger *logger;
+
+        /* IUT port is assumed to be a PCI function named by its address */
+        test_measure_rep_fwd_rate(iut_jobs_ctrl, iut_port->if_info.if_name,
+                                  vf_addrs[0], n, vf_ids, &fwd_pps);
+        if (fwd_pps == 0)
+            TEST_VERDICT("Failure: no packets are forwarded through "
+                         "a representor");
+        if (n == 1)
+            fwd_pps_single = fwd_pps;
+
+        RING("%u representors: %.3f Mpps forwarded through the first "
+             "representor", n, fwd_pps / 1e6);
+
+        CHECK_RC(te_mi_logger_meas_create("dpdk", &logger));
+        te_mi_logger_add_meas_key(logger, NULL, "representors", "%u", n);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_PPS,
+                              "representor_fwd", TE_MI_MEAS_AGGR_MEAN,
+                              fwd_pps, TE_MI_MEAS_MULTIPLIER_PLAIN);
+        te_mi_logger_destroy(logger);
+
+        if (fwd_pps * 100 < fwd_pps_single * (100 - max_slowdown))
+        {
+            TEST_VERDICT("Forwarding through a representor is %.0f%% "
+                         "slower with %u representors",
+                         (1 - fwd_pps / fwd_pps_single) * 100, n);
+        }
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+    if (vf_driver != NULL)
+        CLEANUP_CHECK_RC(tapi_cfg_pci_bind_driver(vf_oid, vf_driver));
+    free(vf_oid);
+    free(vf_driver);
+    free(ethdev_config_reps);
+
+    for (i = 0; i < n_vfs; i++)
+        free(vf_addrs[i]);
+    free(vf_addrs);
+    free(vf_ids);
+
+    TEST_END;
+}
+/** @} */
@@ -0,0 +1,464 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK Port Representors Test Suite
+ * Port representors use cases
+ */
+
+/** @defgroup representors-transfer_rule_churn Transfer flow rules churn
+ * @ingroup representors
+ * @{
+ *
+ * @objective Measure how fast OVS-like transfer flow rules (decap,
+ *            count and represented port actions) are offloaded and
+ *            replaced and check that counters stay accurate under churn
+ *
+ * @param flow_rule_pattern     Encapsulated flow rule pattern
+ * @param tunnel_type           Type of tunnel
+ * @param field_path            ASN.1 path to a field in @p flow_rule_pattern
+ *                              which is changed to make distinct flows
+ * @param n_flows               The number of installed flow rules
+ * @param churn_rate            The number of flow rules to be replaced
+ *                              per second, it is an upper bound since
+ *                              every replacement takes two RPCs
+ * @param duration              Churn duration, seconds
+ * @param nb_pkts               The number of packets per flow to check
+ *                              counters accuracy
+ *
+ * @type performance
+ *
+ * Flow rules are installed on the PF and direct decapsulated traffic
+ * to the VF via its representor the way OVS offloads datapath flows.
+ *
+ * Flow rules are created and destroyed via RPCs, so the achieved churn
+ * rate is limited by RPC latency and is logged as a metric rather than
+ * checked. Miss-to-offload time is measured from the flow rule creation
+ * RPC call to the packet reception on the VF and includes the RPC
+ * exchange of both the rule creation and the packet send and receive.
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME  "representors/transfer_rule_churn"
+
+#include <limits.h>
+#include <sys/time.h>
+
+#include "dpdk_pmd_test.h"
+#include "te_mi_log.h"
+
+/** The number of flows to measure miss-to-offload time and counters on */
+#define TEST_N_SAMPLES 8
+
+static test_transceiver_transform_tmpl transform_tmpl;
+static asn_value *
+transform_tmpl(const asn_value *tmpl_tx, void *unused)
+{
+    UNUSED(unused);
+
+    return test_decap_tmpl_ptrn_pdus(tmpl_tx, "pdus");
+}
+
+static test_transceiver_transform_ptrn transform_ptrn;
+static asn_value *
+transform_ptrn(const asn_value *ptrn_tx, void *unused)
+{
+    UNUSED(unused);
+
+    return test_decap_tmpl_ptrn_pdus(ptrn_tx, "0.pdus");
+}
+
+/** Minimum, maximum and total duration of repeated operations */
+struct test_duration {
+    long long   min;    /**< Minimum duration, microseconds */
+    long long   max;    /**< Maximum duration, microseconds */
+    long long   sum;    /**< Sum of durations, microseconds */
+    unsigned    n;      /**< The number of accounted operations */
+};
+
+static void
+test_duration_reset(struct test_duration *d)
+{
+    d->min = LLONG_MAX;
+    d->max = 0;
+    d->sum = 0;
+    d->n = 0;
+}
+
+static void
+test_duration_account(struct test_duration *d, const struct timeval *start,
+                      const struct timeval *end)
+{
+    long long us = TIMEVAL_SUB(*end, *start);
+
+    d->min = MIN(d->min, us);
+    d->max = MAX(d->max, us);
+    d->sum += us;
+    d->n++;
+}
+
+static void
+test_duration_log(te_mi_logger *logger, const char *name,
+                  const struct test_duration *d)
+{
+    if (d->n == 0)
+        return;
+
+    RING("%s takes %lld/%lld/%lld us (min/mean/max)", name, d->min,
+         d->sum / d->n, d->max);
+
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, name,
+                          TE_MI_MEAS_AGGR_MIN, d->min,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, name,
+                          TE_MI_MEAS_AGGR_MEAN, (double)d->sum / d->n,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, name,
+                          TE_MI_MEAS_AGGR_MAX, d->max,
+                          TE_MI_MEAS_MULTIPLIER_MICRO);
+}
+
+int
+main(int argc, char *argv[])
+{
+    tapi_env_host                          *tst_host;
+    const struct if_nameindex              *tst_if = NULL;
+    rcf_rpc_server                         *iut_rpcs = NULL;
+    const tapi_env_if                      *iut_port = NULL;
+    struct test_ethdev_config               ethdev_config_pf;
+    struct test_ethdev_config              *ethdev_config_vf;
+    struct test_ethdev_config              *ethdev_config_rep;
+    rpc_rte_mempool_p                       mp;
+
+    tarpc_rte_eth_tunnel_type               tunnel_type;
+    asn_value                              *flow_rule_pattern;
+    const char                             *field_path;
+    unsigned int                            n_flows;
+    unsigned int                            churn_rate;
+    unsigned int                            duration;
+    unsigned int                            nb_pkts;
+
+    asn_value                             **flow_rule_patterns = NULL;
+    asn_value                             **tmpls = NULL;
+    rpc_rte_flow_item_p                    *rte_patterns = NULL;
+    rpc_rte_flow_p                         *flows = NULL;
+    asn_value                              *flow_rule_actions;
+    rpc_rte_flow_attr_p                     attr = RPC_NULL;
+    rpc_rte_flow_action_p                   rte_actions = RPC_NULL;
+    rpc_rte_flow_action_p                   rte_count_action = RPC_NULL;
+    tarpc_rte_flow_error                    error;
+    tarpc_rte_flow_query_data               count_query;
+
+    struct test_transceiver_exchange       *exchange = NULL;
+    struct test_transceiver                *trsc_net = NULL;
+    struct test_transceiver                *trsc_pf = NULL;
+    struct test_transceiver                *trsc_vf = NULL;
+    unsigned int                            n_vfs;
+    char                                  **vf_addrs;
+    unsigned int                           *vf_ids;
+
+    struct tarpc_ether_addr                 vf_mac;
+    const struct sockaddr                  *iut_alien_mac = NULL;
+    const struct sockaddr                  *tst_alien_mac = NULL;
+    const struct sockaddr                  *tst_lladdr = NULL;
+    const struct sockaddr                  *iut_addr = NULL;
+    const struct sockaddr                  *tst_addr = NULL;
+    struct test_pkt_addresses               addrs;
+    struct test_pkt_addresses               ifrm_addrs;
+    uint32_t                                decap_pkt_size;
+
+    struct test_duration                    insert;
+    struct test_duration                    remove;
+    struct test_duration                    miss_to_offload;
+    struct timeval                          tv_start;
+    struct timeval                          tv_end;
+    struct timeval                          tv_op;
+    struct timeval                          tv_op_end;
+    long long                               elapsed_us;
+    unsigned long long                      n_replaced;
+    unsigned long long                      i;
+    double                                  insert_rate;
+    double                                  achieved_rate;
+    te_mi_logger                           *logger;
+
+    TEST_START;
+    TEST_GET_PCO(iut_rpcs);
+    TEST_GET_ENV_IF(iut_port);
+    TEST_GET_HOST(tst_host);
+    TEST_GET_IF(tst_if);
+    TEST_GET_LINK_ADDR(iut_alien_mac);
+    TEST_GET_LINK_ADDR(tst_alien_mac);
+    TEST_GET_LINK_ADDR(tst_lladdr);
+    TEST_GET_ADDR_NO_PORT(iut_addr);
+    TEST_GET_ADDR_NO_PORT(tst_addr);
+    TEST_GET_NDN_RTE_FLOW_PATTERN(flow_rule_pattern);
+    TEST_GET_TUNNEL_TYPE(tunnel_type);
+    TEST_GET_STRING_PARAM(field_path);
+    TEST_GET_UINT_PARAM(n_flows);
+    TEST_GET_UINT_PARAM(churn_rate);
+    TEST_GET_UINT_PARAM(duration);
+    TEST_GET_UINT_PARAM(nb_pkts);
+
+    if (n_flows < TEST_N_SAMPLES)
+        TEST_VERDICT("The number of flows must be at least %u", TEST_N_SAMPLES);
+    if (churn_rate == 0)
+        TEST_VERDICT("Churn rate must be positive");
+
+    memset(&count_query, 0, sizeof(count_query));
+    test_duration_reset(&insert);
+    test_duration_reset(&remove);
+    test_duration_reset(&miss_to_offload);
+
+    test_prepare_config_def_mk(&env, iut_rpcs, &iut_port->if_info,
+                               &ethdev_config_pf);
+    test_get_vf_pci_addrs_by_node(tapi_env_get_if_net_node(iut_port),
+                                  &n_vfs, &vf_addrs, &vf_ids);
+
+    TEST_STEP("Create a big enough mempool for PF, VF and representor ports");
+    mp = test_rte_pktmbuf_pool_create(iut_rpcs, TEST_PKTS_MEMPOOL_NAME,
+                                     TEST_RTE_MEMPOOL_DEF_SIZE,
+                                     TEST_RTE_MEMPOOL_DEF_CACHE,
+                                     TEST_RTE_MEMPOOL_DEF_PRIV_SIZE,
+                                     TEST_RTE_MEMPOOL_DEF_DATA_ROOM,
+                                     rpc_rte_eth_dev_socket_id(iut_rpcs,
+                                            iut_port->if_info.if_index));
+
+    TEST_STEP("Hotplug the VF and its representor");
+    test_hotplug_reps(iut_rpcs, &env, tapi_env_get_if_net_node(iut_port),
+                      1, vf_ids, &ethdev_config_rep);
+    test_hotplug_vfs_by_ids(iut_rpcs, &env, tapi_env_get_if_net_node(iut_port),
+                            1, vf_ids, &ethdev_config_vf);
+
+    TEST_STEP("Start PF, VF and representor ports");
+    ethdev_config_vf->mp = ethdev_config_pf.mp = ethdev_config_rep->mp = mp;
+    CHECK_RC(test_prepare_ethdev(&ethdev_config_pf, TEST_ETHDEV_STARTED));
+    CHECK_RC(test_prepare_ethdev(ethdev_config_rep, TEST_ETHDEV_STARTED));
+    CHECK_RC(test_prepare_ethdev(ethdev_config_vf, TEST_ETHDEV_STARTED));
+
+    TEST_STEP("Since DST addresses are alien, enable promiscuous mode on IUT");
+    test_rte_eth_promiscuous_enable(iut_rpcs, ethdev_config_pf.port_id,
+                                    TEST_OP_REQUIRED);
+    test_rte_eth_promiscuous_enable(iut_rpcs, ethdev_config_vf->port_id,
+                                    TEST_OP_REQUIRED);
+
+    trsc_net = test_transceiver_net_init(tst_host->ta, tst_if->if_name);
+    trsc_pf = test_transceiver_dpdk_init(iut_rpcs, ethdev_config_pf.port_id,
+                                         ethdev_config_pf.mp);
+    trsc_vf = test_transceiver_dpdk_init(iut_rpcs, ethdev_config_vf->port_id,
+                                         ethdev_config_vf->mp);
+
+    TEST_STEP("Generate @p n_flows flow rule patterns by changing "
+              "@p field_path and make matching templates");
+    CHECK_RC(tapi_ndn_subst_env(flow_rule_pattern, &test_params, &env));
+    flow_rule_patterns = tapi_calloc(n_flows, sizeof(*flow_rule_patterns));
+    tmpls = tapi_calloc(n_flows, sizeof(*tmpls));
+    rte_patterns = tapi_calloc(n_flows, sizeof(*rte_patterns));
+    flows = tapi_calloc(n_flows, sizeof(*flows));
+
+    flow_rule_patterns[0] = flow_rule_pattern;
+    if (n_flows > 1)
+    {
+        CHECK_RC(test_generate_changed_flow_patterns(flow_rule_pattern,
+                                                     field_path, n_flows - 1,
+                                                     &flow_rule_patterns[1]));
+    }
+
+    rpc_rte_eth_macaddr_get(iut_rpcs, ethdev_config_vf->port_id, &vf_mac);
+    test_set_pkt_addresses(&addrs, (uint8_t *)tst_lladdr->sa_data,
+                           (uint8_t *)iut_alien_mac->sa_data,
+                           tst_addr, iut_addr);
+    test_set_pkt_addresses(&ifrm_addrs, (uint8_t *)tst_alien_mac->sa_data,
+                           vf_mac.addr_bytes, tst_addr, iut_addr);
+
+    for (i = 0; i < n_flows; i++)
+    {
+        test_mk_pattern_and_tmpl_by_flow_rule_pattern(iut_rpcs,
+                                                      flow_rule_patterns[i],
+                                                      &rte_patterns[i],
+                                                      &tmpls[i], NULL);
+        CHECK_RC(test_fill_in_tmpl_req_fields(tmpls[i], &addrs, &ifrm_addrs));
+    }
+    decap_pkt_size = test_get_template_packet_length(iut_rpcs,
+                            test_decap_tmpl_ptrn_pdus(tmpls[0], "pdus"), mp);
+
+    TEST_STEP("Make flow rule attributes with transfer and actions decap, "
+              "count and represented port of the VF");
+    tapi_rte_flow_make_attr(iut_rpcs, 0, 0, FALSE, FALSE, TRUE, &attr);
+
+    CHECK_NOT_NULL(flow_rule_actions = asn_init_value(ndn_rte_flow_actions));
+    tapi_rte_flow_add_ndn_action_decap(flow_rule_actions, 0, tunnel_type);
+    test_add_and_mk_rte_flow_action_count(0, -1, iut_rpcs, flow_rule_actions,
+                                          &rte_count_action);
+    tapi_rte_flow_add_ndn_action_port(NDN_FLOW_ACTION_TYPE_REPRESENTED_PORT,
+                                      ethdev_config_rep->port_id,
+                                      flow_rule_actions, -1);
+    rpc_rte_mk_flow_rule_components(iut_rpcs, flow_rule_actions, NULL, NULL,
+                                    &rte_actions);
+
+    TEST_STEP("Validate the flow rule and make sure that traffic of the flow "
+              "reaches the VF");
+    flows[0] = tapi_rte_flow_validate_and_create_rule(iut_rpcs,
+                    ethdev_config_pf.port_id, attr, rte_patterns[0],
+                    rte_actions);
+    exchange = test_transceiver_exchange_init(tmpls[0], transform_tmpl, NULL,
+                                              transform_ptrn, NULL);
+    test_transceiver_exchange_commit(exchange, trsc_net, 1, 0,
+                                     trsc_vf, 1, 0);
+    test_transceiver_exchange_free(exchange);
+    exchange = NULL;
+
+    TEST_STEP("Install all flow rules and measure insertion rate");
+    gettimeofday(&tv_start, NULL);
+    for (i = 1; i < n_flows; i++)
+    {
+        gettimeofday(&tv_op, NULL);
+        flows[i] = rpc_rte_flow_create(iut_rpcs, ethdev_config_pf.port_id,
+                                       attr, rte_patterns[i], rte_actions,
+                                       &error);
+        gettimeofday(&tv_op_end, NULL);
+        test_duration_account(&insert, &tv_op, &tv_op_end);
+    }
+    gettimeofday(&tv_end, NULL);
+    elapsed_us = TIMEVAL_SUB(tv_end, tv_start);
+    insert_rate = (elapsed_us > 0) ?
+                  (double)(n_flows - 1) * 1000000 / elapsed_us : 0;
+
+    TEST_STEP("Replace flow rules one by one with @p churn_rate during "
+              "@p duration");
+    n_replaced = (unsigned long long)churn_rate * duration;
+    gettimeofday(&tv_start, NULL);
+    for (i = 0; i < n_replaced; i++)
+    {
+        unsigned int k = i % n_flows;
+        long long due_us = i * 1000000ULL / churn_rate;
+
+        gettimeofday(&tv_op, NULL);
+        elapsed_us = TIMEVAL_SUB(tv_op, tv_start);
+        if (elapsed_us < due_us)
+            usleep(due_us - elapsed_us);
+
+        gettimeofday(&tv_op, NULL);
+        rpc_rte_flow_destroy(iut_rpcs, ethdev_config_pf.port_id, flows[k],
+                             &error);
+        flows[k] = RPC_NULL;
+        gettimeofday(&tv_op_end, NULL);
+        test_duration_account(&remove, &tv_op, &tv_op_end);
+
+        tv_op = tv_op_end;
+        flows[k] = rpc_rte_flow_create(iut_rpcs, ethdev_config_pf.port_id,
+                                       attr, rte_patterns[k], rte_actions,
+                                       &error);
+        gettimeofday(&tv_op_end, NULL);
+        test_duration_account(&insert, &tv_op, &tv_op_end);
+    }
+    gettimeofday(&tv_end, NULL);
+    elapsed_us = TIMEVAL_SUB(tv_end, tv_start);
+    achieved_rate = (elapsed_us > 0) ?
+                    (double)n_replaced * 1000000 / elapsed_us : 0;
+
+    TEST_STEP("Measure miss-to-offload time: make sure that a packet "
+              "of a flow without rule reaches the PF, create the rule "
+              "and wait for the packet of the flow on the VF");
+    for (i = 0; i < TEST_N_SAMPLES; i++)
+    {
+        rpc_rte_flow_destroy(iut_rpcs, ethdev_config_pf.port_id, flows[i],
+                             &error);
+        flows[i] = RPC_NULL;
+
+        test_transciever_simple_exchange_commit(tmpls[i], trsc_net, 1, 0,
+                                                trsc_pf, 1, 0, NULL, NULL);
+
+        exchange = test_transceiver_exchange_init(tmpls[i], transform_tmpl,
+                                                  NULL, transform_ptrn, NULL);
+        gettimeofday(&tv_op, NULL);
+        flows[i] = rpc_rte_flow_create(iut_rpcs, ethdev_config_pf.port_id,
+                                       attr, rte_patterns[i], rte_actions,
+                                       &error);
+        test_transceiver_exchange_commit(exchange, trsc_net, 1, 0,
+                                         trsc_vf, 1, 0);
+        gettimeofday(&tv_op_end, NULL);
+        test_duration_account(&miss_to_offload, &tv_op, &tv_op_end);
+
+        test_transceiver_exchange_free(exchange);
+        exchange = NULL;
+    }
+
+    TEST_STEP("Send @p nb_pkts packets per sampled flow and check that "
+              "flow rule counters are accurate");
+    for (i = 0; i < TEST_N_SAMPLES; i++)
+    {
+        exchange = test_transceiver_exchange_init(tmpls[i], transform_tmpl,
+                                                  NULL, transform_ptrn, NULL);
+        test_transceiver_exchange_commit(exchange, trsc_net, nb_pkts, 0,
+                                         trsc_vf, nb_pkts, 0);
+        test_transceiver_exchange_free(exchange);
+        exchange = NULL;
+    }
+
+    /* FIXME: get sleep time from configurator */
+    SLEEP(1);
+
+    for (i = 0; i < TEST_N_SAMPLES; i++)
+    {
+        /* The packet which hit the rule on miss-to-offload is counted too */
+        uint64_t expected_hits = nb_pkts + 1;
+
+        rpc_rte_flow_query(iut_rpcs, ethdev_config_pf.port_id, flows[i],
+                           rte_count_action, &count_query, &error);
+        test_check_flow_query_data(&count_query, TRUE, expected_hits,
+                                   TRUE, expected_hits * decap_pkt_size);
+    }
+
+    TEST_STEP("Log the results");
+    RING("%u flow rules inserted at %.1f rules/s, %llu rules replaced at "
+         "%.1f rules/s (%u rules/s requested)", n_flows, insert_rate,
+         n_replaced, achieved_rate, churn_rate);
+
+    CHECK_RC(te_mi_logger_meas_create("dpdk", &logger));
+    te_mi_logger_add_meas_key(logger, NULL, "flows", "%u", n_flows);
+    te_mi_logger_add_meas_key(logger, NULL, "churn_rate", "%u", churn_rate);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_RPS, "insertion_rate",
+                          TE_MI_MEAS_AGGR_SINGLE, insert_rate,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_RPS, "churn_rate",
+                          TE_MI_MEAS_AGGR_SINGLE, achieved_rate,
+                          TE_MI_MEAS_MULTIPLIER_PLAIN);
+    te_mi_logger_add_comment(logger, NULL, "churn_rate_achieved_percent",
+                             "%.1f", achieved_rate * 100 / churn_rate);
+    test_duration_log(logger, "rule_insert", &insert);
+    test_duration_log(logger, "rule_remove", &remove);
+    test_duration_log(logger, "miss_to_offload", &miss_to_offload);
+    te_mi_logger_destroy(logger);
+
+    TEST_SUCCESS;
+
+cleanup:
+    test_transceiver_exchange_free(exchange);
+
+    if (flows != NULL)
+    {
+        for (i = 0; i < n_flows; i++)
+        {
+            if (flows[i] != RPC_NULL)
+            {
+                rpc_rte_flow_destroy(iut_rpcs, ethdev_config_pf.port_id,
+                                     flows[i], &error);
+            }
+        }
+    }
+
+    if (rte_patterns != NULL)
+    {
+        for (i = 0; i < n_flows; i++)
+            rpc_rte_free_flow_rule(iut_rpcs, RPC_NULL, rte_patterns[i], RPC_NULL);
+    }
+    rpc_rte_free_flow_rule(iut_rpcs, attr, RPC_NULL, rte_actions);
+    rpc_rte_free_flow_rule(iut_rpcs, RPC_NULL, RPC_NULL, rte_count_action);
+
+    test_transceiver_free(trsc_net);
+    test_transceiver_free(trsc_pf);
+    test_transceiver_free(trsc_vf);
+
+    TEST_END;
+}
+/** @} */
@@ -0,0 +1,232 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/* (c) Copyright 2016 - 2022 Xilinx, Inc. All rights reserved. */
+/*
+ * DPDK PMD Test Suite
+ * Reliability in normal use
+ */
+
+/** @defgroup usecases-dev_state_latency Ethernet device state transitions latency
+ * @ingroup usecases
+ * @{
+ *
+ * @objective Measure how long it takes to configure, set up queues,
+ *            start, stop and restart the Ethernet device depending
+ *            on the number of queues and descriptors
+ *
+ * @param nb_desc       The number of Rx and Tx descriptors per queue
+ * @param nb_repeats    The number of measurements per queues number
+ *
+ * @type performance
+ *
+ * @par Scenario:
+ */
+
+#define TE_TEST_NAME  "usecases/dev_state_latency"
+
+#include <limits.h>
+
+#include "dpdk_pmd_test.h"
+#include "te_mi_log.h"
+
+/** Upper limit of the number of mbufs in the Rx mempool */
+#define TEST_MAX_NB_MBUFS   (1U << 18)
+
+/** Measured state transition */
+struct test_transition {
+    const char         *name;   /**< Transition name to be logged */
+    test_ethdev_state   state;  /**< Target state of the transition */
+    long long           min;    /**< Minimum duration, microseconds */
+    long long           max;    /**< Maximum duration, microseconds */
+    long long           sum;    /**< Sum of durations, microseconds */
+};
+
+enum test_transition_id {
+    TEST_TRANSITION_CONFIGURE = 0,
+    TEST_TRANSITION_RX_SETUP,
+    TEST_TRANSITION_TX_SETUP,
+    TEST_TRANSITION_START,
+    TEST_TRANSITION_STOP,
+    TEST_TRANSITION_RESTART,
+    TEST_TRANSITION_NB,
+};
+
+static struct test_transition transitions[TEST_TRANSITION_NB] = {
+    [TEST_TRANSITION_CONFIGURE] = { "configure", TEST_ETHDEV_CONFIGURED },
+    [TEST_TRANSITION_RX_SETUP] = { "rx_queue_setup", TEST_ETHDEV_RX_SETUP_DONE },
+    [TEST_TRANSITION_TX_SETUP] = { "tx_queue_setup", TEST_ETHDEV_TX_SETUP_DONE },
+    [TEST_TRANSITION_START] = { "start", TEST_ETHDEV_STARTED },
+    [TEST_TRANSITION_STOP] = { "stop", TEST_ETHDEV_STOPPED },
+    [TEST_TRANSITION_RESTART] = { "restart", TEST_ETHDEV_STARTED },
+};
+
+static void
+test_transitions_reset(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < TE_ARRAY_LEN(transitions); i++)
+    {
+        transitions[i].min = LLONG_MAX;
+        transitions[i].max = 0;
+        transitions[i].sum = 0;
+    }
+}
+
+static void
+test_transition_account(enum test_transition_id id,
+                        const struct test_ethdev_config *ethdev_config)
+{
+    struct test_transition *t = &transitions[id];
+    long long duration = ethdev_config->transition_us[t->state];
+
+    t->min = MIN(t->min, duration);
+    t->max = MAX(t->max, duration);
+    t->sum += duration;
+}
+
+static void
+test_transitions_log(uint16_t nb_queues, unsigned int nb_desc,
+                     unsigned int nb_repeats)
+{
+    te_mi_logger *logger;
+    unsigned int i;
+
+    CHECK_RC(te_mi_logger_meas_create("dpdk", &logger));
+
+    te_mi_logger_add_meas_key(logger, NULL, "queues", "%hu", nb_queues);
+    te_mi_logger_add_meas_key(logger, NULL, "descriptors", "%u", nb_desc);
+
+    for (i = 0; i < TE_ARRAY_LEN(transitions); i++)
+    {
+        const struct test_transition *t = &transitions[i];
+
+        RING("%hu queues, %u descriptors: %s takes %lld/%lld/%lld us "
+             "(min/mean/max)", nb_queues, nb_desc, t->name, t->min,
+             t->sum / nb_repeats, t->max);
+
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, t->name,
+                              TE_MI_MEAS_AGGR_MIN, t->min,
+                              TE_MI_MEAS_MULTIPLIER_MICRO);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, t->name,
+                              TE_MI_MEAS_AGGR_MEAN,
+                              (double)t->sum / nb_repeats,
+                              TE_MI_MEAS_MULTIPLIER_MICRO);
+        te_mi_logger_add_meas(logger, NULL, TE_MI_MEAS_LATENCY, t->name,
+                              TE_MI_MEAS_AGGR_MAX, t->max,
+                              TE_MI_MEAS_MULTIPLIER_MICRO);
+    }
+
+    te_mi_logger_destroy(logger);
+}
+
+int
+main(int argc, char *argv[])
+{
+    rcf_rpc_server             *iut_rpcs = NULL;
+    const struct if_nameindex  *iut_port = NULL;
+
+    struct test_ethdev_config   ethdev_config;
+    unsigned int                nb_desc;
+    unsigned int                nb_repeats;
+    uint16_t                    max_queues;
+    uint16_t                    nb_queues;
+    unsigned int                nb_mbufs;
+    unsigned int                i;
+
+    TEST_START;
+    TEST_GET_PCO(iut_rpcs);
+    TEST_GET_IF(iut_port);
+    TEST_GET_UINT_PARAM(nb_desc);
+    TEST_GET_UINT_PARAM(nb_repeats);
+
+    if (nb_desc == 0 || nb_repeats == 0)
+        TEST_VERDICT("The number of descriptors and repeats must be positive");
+
+    TEST_STEP("Initialize the Ethernet device to get its capabilities");
+    CHECK_RC(test_default_prepare_ethdev(&env, iut_rpcs, iut_port,
+                                         &ethdev_config,
+                                         TEST_ETHDEV_INITIALIZED));
+
+    TEST_STEP("Check that @p nb_desc fits Rx and Tx descriptors limits");
+    if (test_desc_nb_violates_limits(nb_desc,
+                                     &ethdev_config.dev_info.rx_desc_lim) ||
+        test_desc_nb_violates_limits(nb_desc,
+                                     &ethdev_config.dev_info.tx_desc_lim))
+        TEST_SKIP("The number of descriptors violates device limits");
+
+    max_queues = MIN(ethdev_config.dev_info.max_rx_queues,
+                     ethdev_config.dev_info.max_tx_queues);
+    nb_mbufs = MIN((unsigned int)max_queues * nb_desc, TEST_MAX_NB_MBUFS);
+    if (nb_mbufs / nb_desc < max_queues)
+    {
+        WARN("Limit the number of queues to %u to fit mempool size",
+             nb_mbufs / nb_desc);
+        max_queues = nb_mbufs / nb_desc;
+    }
+    if (max_queues == 0)
+        TEST_SKIP("Too many descriptors to fill even a single Rx queue");
+
+    TEST_STEP("Create mempool big enough to fill all Rx queues");
+    ethdev_config.mp =
+        test_rte_pktmbuf_rx_pool_create(iut_rpcs, iut_port->if_index,
+                                        &ethdev_config.dev_info,
+                                        TEST_PKTS_MEMPOOL_NAME,
+                                        nb_mbufs +
+                                        TEST_RTE_MEMPOOL_DEF_CACHE * 2 +
+                                        TEST_RTE_MEMPOOL_DEF_EXTRA,
+                                        TEST_RTE_MEMPOOL_DEF_CACHE,
+                                        TEST_RTE_MEMPOOL_DEF_PRIV_SIZE,
+                                        TEST_RTE_MEMPOOL_DEF_DATA_ROOM,
+                                        ethdev_config.socket_id);
+
+    ethdev_config.min_rx_desc = nb_desc;
+    ethdev_config.min_tx_desc = nb_desc;
+    /* Link establishment time is not a property of the PMD under test */
+    ethdev_config.skip_link_up_check = TRUE;
+
+    TEST_STEP("For each number of queues starting from 1 and doubling up to "
+              "maximum supported one measure state transitions latency");
+    for (nb_queues = 1; nb_queues != 0;
+         nb_queues = (nb_queues == max_queues) ? 0 :
+                     MIN(nb_queues * 2, max_queues))
+    {
+        test_transitions_reset();
+
+        for (i = 0; i < nb_repeats; i++)
+        {
+            TEST_SUBSTEP("Configure the device, set up queues and start it");
+            ethdev_config.nb_rx_queue = nb_queues;
+            ethdev_config.nb_tx_queue = nb_queues;
+            CHECK_RC(test_prepare_ethdev(&ethdev_config, TEST_ETHDEV_STARTED));
+            test_transition_account(TEST_TRANSITION_CONFIGURE, &ethdev_config);
+            test_transition_account(TEST_TRANSITION_RX_SETUP, &ethdev_config);
+            test_transition_account(TEST_TRANSITION_TX_SETUP, &ethdev_config);
+            test_transition_account(TEST_TRANSITION_START, &ethdev_config);
+
+            TEST_SUBSTEP("Stop the device");
+            CHECK_RC(test_prepare_ethdev(&ethdev_config, TEST_ETHDEV_STOPPED));
+            test_transition_account(TEST_TRANSITION_STOP, &ethdev_config);
+
+            TEST_SUBSTEP("Restart the device and stop it again");
+            CHECK_RC(test_prepare_ethdev(&ethdev_config, TEST_ETHDEV_STARTED));
+            test_transition_account(TEST_TRANSITION_RESTART, &ethdev_config);
+            CHECK_RC(test_prepare_ethdev(&ethdev_config, TEST_ETHDEV_STOPPED));
+
+            /*
+             * Reconfigure the stopped device on the next iteration
+             * without closing it, see usecases/dev_reconfigure.
+             */
+            ethdev_config.cur_state = TEST_ETHDEV_INITIALIZED;
+        }
+
+        TEST_SUBSTEP("Log latency statistics for the number of queues");
+        test_transitions_log(nb_queues, nb_desc, nb_repeats);
+    }
+
+    TEST_SUCCESS;
+
+cleanup:
+
+    TEST_END;
+}
+/** @} */